@@ -1,16 +1,44 @@
 // sched_opt.c — Event-driven, flag-driven CPU schedulers: FCFS, SJF, SRTF, RR
-// Build: gcc -O2 -std=c11 -Wall -Wextra sched_opt.c -o sched
+// Build: gcc -O2 -std=c11 -Wall -Wextra -pthread main.c -o sched -lm
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/syscall.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <linux/futex.h>
 
 /* ===================== Data types ===================== */
 
 typedef struct { int pid, arrival, burst; } Proc;
 
+/* Per-job input columns beyond PID/Arrival/Burst, laid out by --columns;
+   v[c] is NULL for columns absent from the input. */
+enum { COL_PID=0, COL_ARRIVAL, COL_BURST, COL_PATIENCE, COL_CPU, COL_MEM, COL_TENANT, COL_AFFINITY, COL_CLASS, COL_SERIAL, NCOLS };
+static const char *const COL_NAMES[NCOLS] = {"pid","arrival","burst","patience","cpu","mem","tenant","affinity","class","serial"};
+typedef struct JobExt { int *v[NCOLS]; } JobExt;
+
 typedef struct { int pid; int start; int end; } Seg; /* pid = -1 => IDLE */
 typedef struct {
     Seg *a; int len, cap;
@@ -24,9 +52,10 @@ static void seg_reserve(SegVec *v, int need){
     if (!na) { fprintf(stderr,"OOM\n"); exit(1); }
     v->a = na; v->cap = ncap;
 }
-static void seg_push(SegVec *v, Seg s){ seg_reserve(v, v->len+1); v->a[v->len++] = s; }
+/* v may be NULL: silent runs (sampling, search) skip the timeline */
+static void seg_push(SegVec *v, Seg s){ if (!v) return; seg_reserve(v, v->len+1); v->a[v->len++] = s; }
 static void seg_coalesce(SegVec *v){
-    if (v->len <= 1) return;
+    if (!v || v->len <= 1) return;
     int w = 0;
     for (int i=0;i<v->len;i++){
         if (w==0){ v->a[w++] = v->a[i]; continue; }
@@ -40,30 +69,280 @@ static void seg_free(SegVec *v){ free(v->a); v->a=NULL; v->len=v->cap=0; }
 
 /* ===================== CLI config ===================== */
 
+struct Metrics;
+struct Audit;
+
+/* --recommend objectives */
+enum { OBJ_NONE=0, OBJ_MEAN_RESP=1, OBJ_P99_TAT=2, OBJ_FAIRNESS=3 };
+/* --lock-protocol */
+enum { LP_NONE=0, LP_INHERIT=1, LP_CEILING=2 };
+/* --dispatch (cluster front end) */
+enum { DSP_RANDOM=0, DSP_RR=1, DSP_JSQ=2, DSP_POD=3, DSP_LWL=4 };
+/* --autoscale policies */
+enum { SC_FIXED=0, SC_QUEUE=1, SC_UTIL=2 };
+#define MAX_SCALE 8
+/* --smp affinity masks are one unsigned per job */
+#define SMP_MAX 32
+/* --interference matrix dimension */
+#define SMT_MAX_CLASS 8
+/* --speedup table entries */
+#define MAX_SPEEDUP 64
+
 typedef struct {
     bool run_fcfs, run_sjf, run_srtf, run_rr;
     int quantum;
     bool print_gantt;
+    bool gantt_forced;           /* --gantt: keep the timeline in --pipeline/--lockstep too */
     bool print_pertick;
     bool write_csv;
     char csv_path[256];
+    /* Prometheus export */
+    char metrics_path[256];      /* textfile-collector output, "" = off */
+    int metrics_interval;        /* seconds between periodic textfile writes */
+    int metrics_port;            /* localhost HTTP /metrics, 0 = off */
+    bool daemon;                 /* keep reading workloads, serve until SIGTERM */
+    struct Metrics *metrics;     /* NULL when export is off */
+    char audit_path[256];        /* binary decision log, "" = off */
+    struct Audit *audit;         /* NULL when the log is off */
+    bool profile;                /* --profile-workload */
+    long long profile_window;    /* arrival-count window, 0 = auto */
+    int recommend;               /* OBJ_* objective, 0 = off */
+    int rec_quanta[16], nrec_quanta;
+    double sample_frac;          /* busy-period sampling fraction per stratum */
+    uint64_t seed;
+    bool sample;                 /* --sample: estimate metrics from busy periods */
+    double sample_error;         /* target relative 95% half-width, 0 = one round */
+    int until;                   /* --until horizon, INT_MAX = none */
+    long long max_events;        /* --max-events budget, LLONG_MAX = none */
+    char locks_path[256];        /* critical sections per job, "" = off */
+    int lock_protocol;           /* LP_* for SRTF with --locks */
+    bool pipeline;               /* --pipeline: parse and simulate concurrently */
+    bool lockstep;               /* --lockstep: all selected algorithms, one pass */
+    char norm_prefix[256];       /* --norm tables, "" = off */
+    bool norm_derived;
+    int cluster;                 /* --cluster nodes, 0 = single CPU */
+    int dispatch;                /* DSP_* */
+    int node_algo;               /* ALG_* run on every node */
+    int pod_d;                   /* choices for power-of-d */
+    int nscale;                  /* --autoscale policies to compare, 0 = off */
+    int scale_kind[MAX_SCALE];   /* SC_* */
+    double scale_up[MAX_SCALE], scale_down[MAX_SCALE];   /* thresholds; fixed: CPUs in scale_up */
+    char scale_name[MAX_SCALE][32];
+    int cpus_min, cpus_max;
+    int cooldown, provision_delay;
+    double cpu_cost;             /* per CPU-second */
+    double util_window;          /* time constant of the utilisation average */
+    int cols[NCOLS], ncols;      /* --columns input layout */
+    int patience;                /* --patience default, -1 = wait forever */
+    bool reneging;               /* some job may abandon (set per workload) */
+    const JobExt *ext;           /* extra columns of the current workload */
+    char periodic_path[256];     /* --periodic task set, "" = job list on stdin */
+    long long horizon;           /* periodic horizon, 0 = offset + hyperperiod */
+    bool run_rm, run_dm;
+    int machines;                /* --machines for multi-resource packing, 0 = off */
+    long long mach_cpu, mach_mem;
+    int pack_mask;               /* 1<<PK_* policies to compare */
+    int smp;                     /* --smp CPUs with affinity constraints, 0 = off */
+    bool smt;                    /* --smt: CPU pairs are hyperthread siblings */
+    int smt_classes;
+    double smt_slow[SMT_MAX_CLASS*SMT_MAX_CLASS];   /* [i*C+j]: slowdown of class i beside j */
+    int gang, gang_rows;         /* --gang CPUs (0 = off) and Ousterhout matrix rows */
+    int mold;                    /* --mold CPUs for moldable/malleable jobs, 0 = off */
+    double amdahl;               /* serial fraction when there is no serial column */
+    double speedup[MAX_SPEEDUP]; /* speedup at 1..nspeedup CPUs, flat beyond */
+    int nspeedup;
+    int fixed_width;             /* CPUs per job in the fixed baseline */
+    char gittins_path[256];      /* --gittins class size distributions, "" = off */
+    int exec_alg;                /* --execute: ALG_* replayed on real threads, -1 = off */
+    int tick_us, exec_cpu;
+    int calib_mask;              /* --calibrate: 1 OTHER, 2 RR, 4 FIFO; 0 = off */
+    char calib_cpus[64];
+    int replay_alg;              /* --replay: ALG_* paced to --replay-to, -1 = off */
+    char replay_to[256];
+    double time_scale;           /* wall time per tick = tick_us * time_scale */
+    int adv_alg[2], adv_q[2];    /* --adversary policies A,B; adv_alg[0] = -1 when off */
+    int adv_metric;              /* ADV_* gap metric */
+    int adv_pop, adv_gens;
+    char adv_out[256];           /* prefix of the saved worst-case workloads */
+    char diff_side[2][256];      /* --diff sides: policy or segment file; "" = off */
+    int diff_alg[2], diff_q[2];  /* ALG_* of a live side, -1 for a file */
+    int diff_top;                /* processes listed by completion shift */
+    char seg_prefix[256];        /* --segments timelines, "" = off */
 } Config;
 
 static void config_default(Config *c){
     c->run_fcfs = c->run_sjf = c->run_srtf = c->run_rr = true;
     c->quantum = 2;
     c->print_gantt = true;
+    c->gantt_forced = false;
     c->print_pertick = false;
     c->write_csv = true;
     strcpy(c->csv_path, "schedule_metrics.csv");
+    c->metrics_path[0] = '\0';
+    c->metrics_interval = 10;
+    c->metrics_port = 0;
+    c->daemon = false;
+    c->metrics = NULL;
+    c->audit_path[0] = '\0';
+    c->audit = NULL;
+    c->profile = false;
+    c->profile_window = 0;
+    c->recommend = 0;
+    c->nrec_quanta = 5;
+    for (int i=0;i<5;i++) c->rec_quanta[i] = 1<<i;
+    c->sample_frac = 0.02;
+    c->seed = 1;
+    c->sample = false;
+    c->sample_error = 0;
+    c->until = INT_MAX;
+    c->max_events = LLONG_MAX;
+    c->locks_path[0] = '\0';
+    c->lock_protocol = LP_NONE;
+    c->pipeline = false;
+    c->lockstep = false;
+    c->norm_prefix[0] = '\0';
+    c->norm_derived = false;
+    c->cluster = 0;
+    c->dispatch = DSP_JSQ;
+    c->node_algo = 0;            /* ALG_FCFS */
+    c->pod_d = 2;
+    c->nscale = 0;
+    c->cpus_min = 1; c->cpus_max = 16;
+    c->cooldown = 30; c->provision_delay = 10;
+    c->cpu_cost = 1.0;
+    c->util_window = 30;
+    c->ncols = 3;
+    for (int i=0;i<3;i++) c->cols[i] = i;
+    c->patience = -1;
+    c->reneging = false;
+    c->ext = NULL;
+    c->periodic_path[0] = '\0';
+    c->horizon = 0;
+    c->run_rm = c->run_dm = true;
+    c->machines = 0;
+    c->mach_cpu = 16; c->mach_mem = 64;
+    c->pack_mask = 7;
+    c->smp = 0;
+    c->smt = false;
+    c->smt_classes = 1; c->smt_slow[0] = 1.25;
+    c->gang = 0; c->gang_rows = 8;
+    c->mold = 0;
+    c->amdahl = 0.1;
+    c->nspeedup = 0;
+    c->fixed_width = 1;
+    c->gittins_path[0] = '\0';
+    c->exec_alg = -1;
+    c->tick_us = 1000; c->exec_cpu = 0;
+    c->calib_mask = 0;
+    strcpy(c->calib_cpus, "0");
+    c->replay_alg = -1;
+    strcpy(c->replay_to, "-");
+    c->time_scale = 1.0;
+    c->adv_alg[0] = c->adv_alg[1] = -1;
+    c->adv_metric = 0;           /* ADV_MEAN_TAT */
+    c->adv_pop = 64; c->adv_gens = 200;
+    strcpy(c->adv_out, "adversary");
+    c->diff_side[0][0] = c->diff_side[1][0] = '\0';
+    c->diff_alg[0] = c->diff_alg[1] = -1;
+    c->diff_top = 10;
+    c->seg_prefix[0] = '\0';
 }
 static void print_help(const char *prog){
-    printf("Usage: %s [--algo=all|fcfs,sjf,srtf,rr] [--quantum=Q] [--csv=FILE|--no-csv] [--no-gantt] [--per-tick]\n", prog);
+    printf("Usage: %s [options] < workload\n"
+           "       %s decode-audit FILE\n"
+           "  --algo=all|none|fcfs,sjf,srtf,rr  algorithms to run (default all)\n"
+           "  --quantum=Q                   Round Robin quantum (default 2)\n"
+           "  --csv=FILE | --no-csv         per-process CSV output\n"
+           "  --norm=PREFIX                 also write PREFIX_workload.csv once plus slim\n"
+           "                                PREFIX_<algo>.csv tables (Row,Start,Completion)\n"
+           "  --norm-derived                add Response,Waiting,Turnaround to the --norm tables\n"
+           "  --gantt | --no-gantt | --per-tick  timeline printing (--pipeline/--lockstep\n"
+           "                                keep no timeline unless --gantt or --per-tick)\n"
+           "  --columns=pid,arrival,burst[,...]  per-job input columns, in order; optional:\n"
+           "                                patience, cpu, mem, tenant, affinity, class, serial\n"
+           "  --patience=T                  jobs not started within T of arrival leave\n"
+           "                                (a patience column overrides; negative = never)\n"
+           "  --periodic=FILE               periodic tasks (ID PERIOD WCET OFFSET [DEADLINE]) instead of stdin\n"
+           "  --fp=rm,dm                    fixed-priority engines for --periodic (default both)\n"
+           "  --horizon=T                   periodic horizon (default max offset + hyperperiod)\n"
+           "  --until=T                     stop at simulated time T and report partial results\n"
+           "  --max-events=N                stop after about N engine events\n"
+           "  --pipeline                    simulate one algorithm while a parser thread reads\n"
+           "                                arrival-sorted input (CSV rows in completion order)\n"
+           "  --lockstep                    like --pipeline, for all selected algorithms in one pass\n"
+           "  --cluster=N                   dispatch jobs over N nodes, each running --node-algo\n"
+           "  --dispatch=random|rr|jsq|pod|lwl  front-end policy (default jsq)\n"
+           "  --node-algo=fcfs|sjf|srtf|rr  local scheduler on every node (default fcfs)\n"
+           "  --pod-d=D                     choices for --dispatch=pod (default 2)\n"
+           "  --autoscale=fixed:K|queue:UP:DOWN|util:HI:LO\n"
+           "                                multi-CPU run with a scaling policy (repeat to compare);\n"
+           "                                queue thresholds are waiting jobs per CPU\n"
+           "  --cpus=MIN:MAX                CPU range for --autoscale (default 1:16)\n"
+           "  --cooldown=T | --provision-delay=T  scaling cooldown (30) and boot delay (10)\n"
+           "  --cpu-cost=RATE               cost per CPU-second (default 1)\n"
+           "  --util-window=T               time constant of the utilisation average (default 30)\n"
+           "  --machines=M                  pack cpu/mem jobs onto M machines (drf, first-fit, best-fit)\n"
+           "  --capacity=CPU:MEM            per-machine capacity for --machines (default 16:64)\n"
+           "  --pack=drf,ff,bf              packing policies to compare (default all)\n"
+           "  --smp=K                       K CPUs sharing a --node-algo fcfs|sjf queue; the affinity\n"
+           "                                column is a CPU bitmask (0 = any), K <= 32\n"
+           "  --smt                         with --smp: CPUs 2c and 2c+1 share a core; compares\n"
+           "                                first, spread and interference-aware pair placement\n"
+           "  --interference=a,b/c,d        slowdown of job class (row) beside class (column)\n"
+           "                                for --smt (default 1.25, one class)\n"
+           "  --gang=P                      gang-schedule jobs needing cpu-column CPUs on P CPUs,\n"
+           "                                rotating matrix rows every --quantum\n"
+           "  --gang-rows=R                 time slots in the Ousterhout matrix (default 8)\n"
+           "  --mold=P                      fixed vs moldable vs malleable parallel jobs on P CPUs\n"
+           "  --amdahl=F                    serial fraction for --mold (default 0.1; serial column\n"
+           "                                in percent overrides)\n"
+           "  --speedup=S1,S2,...           explicit speedup at 1,2,... CPUs instead of Amdahl\n"
+           "  --fixed-width=W               CPUs per job in the fixed baseline (default 1)\n"
+           "  --gittins=FILE                also run the Gittins index engine; lines of CLASS SIZE WEIGHT\n"
+           "                                give per-class size distributions (class column, default 0)\n"
+           "  --execute=fcfs|sjf|srtf|rr    replay that schedule with busy-loop threads pinned to one\n"
+           "                                CPU and compare measured with simulated times\n"
+           "  --tick-us=U | --exec-cpu=C    wall time per tick (default 1000) and CPU for --execute\n"
+           "  --calibrate=other,rr,fifo     run the workload as real processes under these kernel\n"
+           "                                policies (RT ones need privileges); CSV rows Kernel-*\n"
+           "  --calib-cpus=LIST             CPUs for --calibrate children, e.g. 2-3 (default 0)\n"
+           "  --replay=fcfs|sjf|srtf|rr     emit DISPATCH/PREEMPT/COMPLETE lines in wall-clock time\n"
+           "  --replay-to=PATH|unix:PATH|-  destination for --replay (default stdout)\n"
+           "  --time-scale=S                stretch (>1) or compress (<1) --replay time\n"
+           "  --adversary=A,B               search workloads maximising metric(A)/metric(B); A and B\n"
+           "                                are fcfs, sjf, srtf, rr, rrQ or opt (SRTF)\n"
+           "  --adv-metric=mean-tat|max-tat|mean-resp  gap metric (default mean-tat)\n"
+           "  --adv-pop=N | --adv-gens=G    search population (default 64) and generations (200)\n"
+           "  --adv-out=PREFIX              worst workloads saved as PREFIX_1.txt.. (default adversary)\n"
+           "  --segments=PREFIX             save each run's timeline as PREFIX_<algo>.seg\n"
+           "                                (lines of: START END PID, PID -1 = idle)\n"
+           "  --diff=A,B                    compare two timelines; each side is a policy run on\n"
+           "                                the workload (fcfs, sjf, srtf, rr, rrQ) or a .seg file\n"
+           "  --diff-top=K                  processes listed by completion shift (default 10)\n"
+           "  --locks=FILE                  critical sections, lines of: PID RESOURCE OFFSET LENGTH\n"
+           "  --lock-protocol=none|inherit|ceiling\n"
+           "                                SRTF handling of lock holders (default none)\n"
+           "  --metrics-file=FILE           Prometheus textfile-collector export\n"
+           "  --metrics-interval=SEC        periodic rewrite of --metrics-file (default 10)\n"
+           "  --metrics-port=PORT           serve /metrics on 127.0.0.1:PORT\n"
+           "  --daemon                      process workloads until EOF, then serve until SIGTERM\n"
+           "  --audit=FILE                  binary log of every dispatch/preemption/completion\n"
+           "  --profile-workload            print load, burstiness, tail and busy-period statistics\n"
+           "  --profile-window=W            window for the arrival index of dispersion (default auto)\n"
+           "  --recommend=mean-response|p99-turnaround|fairness\n"
+           "                                pick a policy from pilot runs on sampled busy periods\n"
+           "  --rec-quanta=Q1,Q2,...        RR quanta considered by --recommend (default 1,2,4,8,16)\n"
+           "  --sample-frac=F               fraction of busy periods sampled per stratum (default 0.02)\n"
+           "  --seed=N                      random seed for sampling\n"
+           "  --sample                      estimate metrics with CIs from sampled busy periods\n"
+           "  --sample-error=E              refine --sample until 95%% CIs are within E relative\n",
+           prog, prog);
 }
 
 static void parse_algos(Config *c, const char *val){
     c->run_fcfs = c->run_sjf = c->run_srtf = c->run_rr = false;
     if (strcmp(val,"all")==0){ c->run_fcfs=c->run_sjf=c->run_srtf=c->run_rr=true; return; }
+    if (strcmp(val,"none")==0) return;
     char buf[128]; strncpy(buf,val,sizeof(buf)-1); buf[sizeof(buf)-1]='\0';
     char *tok = strtok(buf,",");
     while (tok){
@@ -76,18 +355,314 @@ static void parse_algos(Config *c, const char *val){
     }
 }
 
+/* One policy of --adversary/--diff: fcfs|sjf|srtf|rr|rrQ|opt (SRTF). Returns
+   the ALG_* index or -1; *q is 0 for a bare rr (filled from --quantum later). */
+static int parse_policy(const char *tok, int *q){
+    static const char *A[] = {"fcfs","sjf","srtf","rr"};
+    int alg = -1; *q = 0;
+    for (int a=0; a<4; a++) if (!strcmp(tok, A[a])) alg = a;
+    if (!strcmp(tok,"opt")) alg = 2;
+    else if (!strncmp(tok,"rr",2) && atoi(tok+2) > 0){ alg = 3; *q = atoi(tok+2); }
+    return alg;
+}
+
 static void parse_args(Config *c, int argc, char **argv){
     for (int i=1;i<argc;i++){
-        if (!strncmp(argv[i],"--algo=",8)) parse_algos(c, argv[i]+8);
+        if (!strncmp(argv[i],"--algo=",7)) parse_algos(c, argv[i]+7);
         else if (!strncmp(argv[i],"--quantum=",10)) c->quantum = atoi(argv[i]+10);
         else if (!strcmp(argv[i],"--no-gantt")) c->print_gantt = false;
+        else if (!strcmp(argv[i],"--gantt")) c->print_gantt = c->gantt_forced = true;
+        else if (!strncmp(argv[i],"--until=",8)) c->until = atoi(argv[i]+8);
+        else if (!strncmp(argv[i],"--periodic=",11)) { strncpy(c->periodic_path, argv[i]+11, sizeof(c->periodic_path)-1); c->periodic_path[sizeof(c->periodic_path)-1]='\0'; }
+        else if (!strncmp(argv[i],"--horizon=",10)) c->horizon = atoll(argv[i]+10);
+        else if (!strncmp(argv[i],"--fp=",5)){
+            char buf[64]; snprintf(buf, sizeof(buf), "%s", argv[i]+5);
+            c->run_rm = c->run_dm = false;
+            for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")){
+                if      (!strcmp(tok,"rm")) c->run_rm = true;
+                else if (!strcmp(tok,"dm")) c->run_dm = true;
+                else { fprintf(stderr,"--fp expects rm, dm or rm,dm\n"); exit(1); }
+            }
+            if (!c->run_rm && !c->run_dm){ fprintf(stderr,"--fp expects rm, dm or rm,dm\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--patience=",11)) c->patience = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--columns=",10)){
+            char buf[256]; snprintf(buf, sizeof(buf), "%s", argv[i]+10);
+            bool seen[NCOLS] = {false};
+            c->ncols = 0;
+            for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")){
+                int col = -1;
+                for (int k=0;k<NCOLS;k++) if (!strcmp(tok, COL_NAMES[k])) col = k;
+                if (col < 0 || seen[col]){ fprintf(stderr,"Unknown or repeated column: %s\n", tok); exit(1); }
+                seen[col] = true; c->cols[c->ncols++] = col;
+            }
+            if (!seen[COL_PID] || !seen[COL_ARRIVAL] || !seen[COL_BURST]){ fprintf(stderr,"--columns needs pid, arrival and burst\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--max-events=",13)) c->max_events = atoll(argv[i]+13);
         else if (!strcmp(argv[i],"--per-tick")) c->print_pertick = true;
+        else if (!strncmp(argv[i],"--norm=",7)) { strncpy(c->norm_prefix, argv[i]+7, sizeof(c->norm_prefix)-1); c->norm_prefix[sizeof(c->norm_prefix)-1]='\0'; }
+        else if (!strcmp(argv[i],"--norm-derived")) c->norm_derived = true;
+        else if (!strncmp(argv[i],"--cluster=",10)) c->cluster = atoi(argv[i]+10);
+        else if (!strncmp(argv[i],"--pod-d=",8)) c->pod_d = atoi(argv[i]+8);
+        else if (!strncmp(argv[i],"--dispatch=",11)){
+            static const char *D[] = {"random","rr","jsq","pod","lwl"};
+            c->dispatch = -1;
+            for (int d=0; d<5; d++) if (!strcmp(argv[i]+11, D[d])) c->dispatch = d;
+            if (c->dispatch < 0){ fprintf(stderr,"Unknown dispatch policy: %s\n", argv[i]+11); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--node-algo=",12)){
+            static const char *A[] = {"fcfs","sjf","srtf","rr"};
+            c->node_algo = -1;
+            for (int a=0; a<4; a++) if (!strcmp(argv[i]+12, A[a])) c->node_algo = a;
+            if (c->node_algo < 0){ fprintf(stderr,"Unknown algo: %s\n", argv[i]+12); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--autoscale=",12)){
+            const char *v = argv[i]+12; double a = 0, b = 0; int kind;
+            if      (sscanf(v, "fixed:%lf", &a) == 1)            kind = SC_FIXED;
+            else if (sscanf(v, "queue:%lf:%lf", &a, &b) == 2)    kind = SC_QUEUE;
+            else if (sscanf(v, "util:%lf:%lf", &a, &b) == 2)     kind = SC_UTIL;
+            else { fprintf(stderr,"Unknown autoscale policy: %s\n", v); exit(1); }
+            if (c->nscale == MAX_SCALE){ fprintf(stderr,"At most %d --autoscale policies\n", MAX_SCALE); exit(1); }
+            if ((kind == SC_FIXED && a < 1) || (kind != SC_FIXED && b > a)){ fprintf(stderr,"Bad thresholds in --autoscale=%s\n", v); exit(1); }
+            c->scale_kind[c->nscale] = kind; c->scale_up[c->nscale] = a; c->scale_down[c->nscale] = b;
+            snprintf(c->scale_name[c->nscale], sizeof(c->scale_name[0]), "%s", v);
+            c->nscale++;
+        }
+        else if (!strncmp(argv[i],"--cpus=",7)){
+            if (sscanf(argv[i]+7, "%d:%d", &c->cpus_min, &c->cpus_max) != 2){ fprintf(stderr,"--cpus expects MIN:MAX\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--cooldown=",11)) c->cooldown = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--provision-delay=",18)) c->provision_delay = atoi(argv[i]+18);
+        else if (!strncmp(argv[i],"--cpu-cost=",11)) c->cpu_cost = atof(argv[i]+11);
+        else if (!strncmp(argv[i],"--util-window=",14)) c->util_window = atof(argv[i]+14);
+        else if (!strncmp(argv[i],"--machines=",11)) c->machines = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--capacity=",11)){
+            if (sscanf(argv[i]+11, "%lld:%lld", &c->mach_cpu, &c->mach_mem) != 2 || c->mach_cpu < 1 || c->mach_cpu > 1<<20 || c->mach_mem < 0){
+                fprintf(stderr,"--capacity expects CPU:MEM with 1 <= CPU <= 2^20, MEM >= 0\n"); exit(1);
+            }
+        }
+        else if (!strncmp(argv[i],"--pack=",7)){
+            char buf[64]; snprintf(buf, sizeof(buf), "%s", argv[i]+7);
+            c->pack_mask = 0;
+            for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")){
+                if      (!strcmp(tok,"drf")) c->pack_mask |= 1;
+                else if (!strcmp(tok,"ff"))  c->pack_mask |= 2;
+                else if (!strcmp(tok,"bf"))  c->pack_mask |= 4;
+                else { fprintf(stderr,"--pack expects drf, ff and/or bf\n"); exit(1); }
+            }
+            if (!c->pack_mask){ fprintf(stderr,"--pack expects drf, ff and/or bf\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--smp=",6)) c->smp = atoi(argv[i]+6);
+        else if (!strcmp(argv[i],"--smt")) c->smt = true;
+        else if (!strncmp(argv[i],"--gang=",7)) c->gang = atoi(argv[i]+7);
+        else if (!strncmp(argv[i],"--gang-rows=",12)) c->gang_rows = atoi(argv[i]+12);
+        else if (!strncmp(argv[i],"--mold=",7)) c->mold = atoi(argv[i]+7);
+        else if (!strncmp(argv[i],"--execute=",10)){
+            static const char *A[] = {"fcfs","sjf","srtf","rr"};
+            c->exec_alg = -1;
+            for (int a=0; a<4; a++) if (!strcmp(argv[i]+10, A[a])) c->exec_alg = a;
+            if (c->exec_alg < 0){ fprintf(stderr,"Unknown algo: %s\n", argv[i]+10); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--calibrate=",12)){
+            char buf[64]; snprintf(buf, sizeof(buf), "%s", argv[i]+12);
+            c->calib_mask = 0;
+            for (char *tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")){
+                if      (!strcmp(tok,"other")) c->calib_mask |= 1;
+                else if (!strcmp(tok,"rr"))    c->calib_mask |= 2;
+                else if (!strcmp(tok,"fifo"))  c->calib_mask |= 4;
+                else { fprintf(stderr,"--calibrate expects other, rr and/or fifo\n"); exit(1); }
+            }
+            if (!c->calib_mask){ fprintf(stderr,"--calibrate expects other, rr and/or fifo\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--calib-cpus=",13)) snprintf(c->calib_cpus, sizeof(c->calib_cpus), "%s", argv[i]+13);
+        else if (!strncmp(argv[i],"--replay=",9)){
+            static const char *A[] = {"fcfs","sjf","srtf","rr"};
+            c->replay_alg = -1;
+            for (int a=0; a<4; a++) if (!strcmp(argv[i]+9, A[a])) c->replay_alg = a;
+            if (c->replay_alg < 0){ fprintf(stderr,"Unknown algo: %s\n", argv[i]+9); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--replay-to=",12)) snprintf(c->replay_to, sizeof(c->replay_to), "%s", argv[i]+12);
+        else if (!strncmp(argv[i],"--time-scale=",13)) c->time_scale = atof(argv[i]+13);
+        else if (!strncmp(argv[i],"--adversary=",12)){
+            char buf[64]; snprintf(buf, sizeof(buf), "%s", argv[i]+12);
+            char *tok = strtok(buf, ","); int k = 0;
+            for (; tok && k < 2; tok = strtok(NULL, ","), k++){
+                c->adv_alg[k] = parse_policy(tok, &c->adv_q[k]);
+                if (c->adv_alg[k] < 0){ fprintf(stderr,"Unknown --adversary policy: %s\n", tok); exit(1); }
+            }
+            if (k != 2 || tok){ fprintf(stderr,"--adversary expects two policies A,B\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--adv-metric=",13)){
+            static const char *M[] = {"mean-tat","max-tat","mean-resp"};
+            c->adv_metric = -1;
+            for (int m=0; m<3; m++) if (!strcmp(argv[i]+13, M[m])) c->adv_metric = m;
+            if (c->adv_metric < 0){ fprintf(stderr,"--adv-metric expects mean-tat, max-tat or mean-resp\n"); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--diff=",7)){
+            /* each side is a policy run live on the workload or a --segments file */
+            const char *v = argv[i]+7, *comma = strchr(v, ',');
+            if (!comma || !comma[1] || comma == v || strchr(comma+1, ',')){ fprintf(stderr,"--diff expects two sides A,B\n"); exit(1); }
+            snprintf(c->diff_side[0], sizeof(c->diff_side[0]), "%.*s", (int)(comma - v), v);
+            snprintf(c->diff_side[1], sizeof(c->diff_side[1]), "%s", comma+1);
+            for (int k=0;k<2;k++) c->diff_alg[k] = parse_policy(c->diff_side[k], &c->diff_q[k]);
+        }
+        else if (!strncmp(argv[i],"--diff-top=",11)) c->diff_top = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--segments=",11)) snprintf(c->seg_prefix, sizeof(c->seg_prefix), "%s", argv[i]+11);
+        else if (!strncmp(argv[i],"--adv-pop=",10)) c->adv_pop = atoi(argv[i]+10);
+        else if (!strncmp(argv[i],"--adv-gens=",11)) c->adv_gens = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--adv-out=",10)) snprintf(c->adv_out, sizeof(c->adv_out), "%s", argv[i]+10);
+        else if (!strncmp(argv[i],"--tick-us=",10)) c->tick_us = atoi(argv[i]+10);
+        else if (!strncmp(argv[i],"--exec-cpu=",11)) c->exec_cpu = atoi(argv[i]+11);
+        else if (!strncmp(argv[i],"--gittins=",10)) { strncpy(c->gittins_path, argv[i]+10, sizeof(c->gittins_path)-1); c->gittins_path[sizeof(c->gittins_path)-1]='\0'; }
+        else if (!strncmp(argv[i],"--amdahl=",9)) c->amdahl = atof(argv[i]+9);
+        else if (!strncmp(argv[i],"--fixed-width=",14)) c->fixed_width = atoi(argv[i]+14);
+        else if (!strncmp(argv[i],"--speedup=",10)){
+            c->nspeedup = 0;
+            for (const char *v = argv[i]+10; *v && c->nspeedup < MAX_SPEEDUP; ){
+                double x = atof(v);
+                if (x <= 0){ fprintf(stderr,"Speedups must be > 0\n"); exit(1); }
+                c->speedup[c->nspeedup++] = x;
+                v = strchr(v, ','); if (!v) break; v++;
+            }
+        }
+        else if (!strncmp(argv[i],"--interference=",15)){
+            int rows = 0, cols = 0, k = 0;
+            for (const char *v = argv[i]+15; *v; ){
+                char *e; double x = strtod(v, &e);
+                if (e == v || x < 1 || k == SMT_MAX_CLASS*SMT_MAX_CLASS){ fprintf(stderr,"--interference expects slowdowns >= 1, rows split by '/', at most %d classes\n", SMT_MAX_CLASS); exit(1); }
+                c->smt_slow[k++] = x; v = e;
+                if (*v == ',') v++;
+                else if (*v == '/' || !*v){
+                    rows++;
+                    if (!cols) cols = k;
+                    if (k != rows * cols){ fprintf(stderr,"--interference rows must have equal length\n"); exit(1); }
+                    if (*v) v++;
+                }
+                else { fprintf(stderr,"--interference: unexpected '%c'\n", *v); exit(1); }
+            }
+            if (rows < 1 || rows != cols || rows > SMT_MAX_CLASS){ fprintf(stderr,"--interference must be square, at most %dx%d\n", SMT_MAX_CLASS, SMT_MAX_CLASS); exit(1); }
+            c->smt_classes = rows;
+        }
+        else if (!strcmp(argv[i],"--pipeline")) c->pipeline = true;
+        else if (!strcmp(argv[i],"--lockstep")) c->lockstep = true;
+        else if (!strncmp(argv[i],"--locks=",8)) { strncpy(c->locks_path, argv[i]+8, sizeof(c->locks_path)-1); c->locks_path[sizeof(c->locks_path)-1]='\0'; }
+        else if (!strncmp(argv[i],"--lock-protocol=",16)){
+            const char *v = argv[i]+16;
+            if      (!strcmp(v,"none"))    c->lock_protocol = LP_NONE;
+            else if (!strcmp(v,"inherit")) c->lock_protocol = LP_INHERIT;
+            else if (!strcmp(v,"ceiling")) c->lock_protocol = LP_CEILING;
+            else { fprintf(stderr,"Unknown lock protocol: %s\n", v); exit(1); }
+        }
         else if (!strcmp(argv[i],"--no-csv")) c->write_csv = false;
         else if (!strncmp(argv[i],"--csv=",6)) { c->write_csv = true; strncpy(c->csv_path, argv[i]+6, sizeof(c->csv_path)-1); c->csv_path[sizeof(c->csv_path)-1]='\0'; }
+        else if (!strncmp(argv[i],"--metrics-file=",15)) { strncpy(c->metrics_path, argv[i]+15, sizeof(c->metrics_path)-1); c->metrics_path[sizeof(c->metrics_path)-1]='\0'; }
+        else if (!strncmp(argv[i],"--metrics-interval=",19)) c->metrics_interval = atoi(argv[i]+19);
+        else if (!strncmp(argv[i],"--metrics-port=",15)) c->metrics_port = atoi(argv[i]+15);
+        else if (!strcmp(argv[i],"--daemon")) c->daemon = true;
+        else if (!strcmp(argv[i],"--profile-workload")) c->profile = true;
+        else if (!strncmp(argv[i],"--profile-window=",17)) c->profile_window = atoll(argv[i]+17);
+        else if (!strncmp(argv[i],"--recommend=",12)){
+            const char *v = argv[i]+12;
+            if      (!strcmp(v,"mean-response"))  c->recommend = OBJ_MEAN_RESP;
+            else if (!strcmp(v,"p99-turnaround")) c->recommend = OBJ_P99_TAT;
+            else if (!strcmp(v,"fairness"))       c->recommend = OBJ_FAIRNESS;
+            else { fprintf(stderr,"Unknown objective: %s\n", v); exit(1); }
+        }
+        else if (!strncmp(argv[i],"--rec-quanta=",13)){
+            c->nrec_quanta = 0;
+            for (const char *v = argv[i]+13; *v && c->nrec_quanta < 16; ){
+                int qv = atoi(v);
+                if (qv <= 0){ fprintf(stderr,"Quantum must be > 0\n"); exit(1); }
+                c->rec_quanta[c->nrec_quanta++] = qv;
+                v = strchr(v, ','); if (!v) break; v++;
+            }
+        }
+        else if (!strncmp(argv[i],"--sample-frac=",14)) c->sample_frac = atof(argv[i]+14);
+        else if (!strcmp(argv[i],"--sample")) c->sample = true;
+        else if (!strncmp(argv[i],"--sample-error=",15)) c->sample_error = atof(argv[i]+15);
+        else if (!strncmp(argv[i],"--seed=",7)) c->seed = strtoull(argv[i]+7, NULL, 10);
+        else if (!strncmp(argv[i],"--audit=",8)) { strncpy(c->audit_path, argv[i]+8, sizeof(c->audit_path)-1); c->audit_path[sizeof(c->audit_path)-1]='\0'; }
         else if (!strcmp(argv[i],"--help") || !strcmp(argv[i],"-h")) { print_help(argv[0]); exit(0); }
         else { fprintf(stderr,"Unknown option: %s\n", argv[i]); print_help(argv[0]); exit(1); }
     }
     if (c->quantum <= 0){ fprintf(stderr,"Quantum must be > 0\n"); exit(1); }
+    if (c->until < 0 || c->max_events < 0){ fprintf(stderr,"Limits must be >= 0\n"); exit(1); }
+    if (c->sample_frac <= 0 || c->sample_frac > 1){ fprintf(stderr,"Sample fraction must be in (0,1]\n"); exit(1); }
+    if (c->metrics_interval <= 0){ fprintf(stderr,"Metrics interval must be > 0\n"); exit(1); }
+    if (c->metrics_port < 0 || c->metrics_port > 65535){ fprintf(stderr,"Metrics port must be in 0..65535\n"); exit(1); }
+    if (c->cluster < 0 || c->pod_d <= 0){ fprintf(stderr,"--cluster and --pod-d must be positive\n"); exit(1); }
+    /* Run modes each take their own path through main; the rest (--gittins,
+       --profile-workload, --norm, --audit, metrics) add to the plain runs. */
+    const char *mode[20]; int nmode = 0;
+    if (c->periodic_path[0]) mode[nmode++] = "--periodic";
+    if (c->recommend) mode[nmode++] = "--recommend";
+    if (c->sample) mode[nmode++] = "--sample";
+    if (c->cluster) mode[nmode++] = "--cluster";
+    if (c->nscale) mode[nmode++] = "--autoscale";
+    if (c->machines) mode[nmode++] = "--machines";
+    if (c->exec_alg >= 0) mode[nmode++] = "--execute";
+    if (c->calib_mask) mode[nmode++] = "--calibrate";
+    if (c->replay_alg >= 0) mode[nmode++] = "--replay";
+    if (c->adv_alg[0] >= 0) mode[nmode++] = "--adversary";
+    if (c->diff_side[0][0]) mode[nmode++] = "--diff";
+    if (c->gang) mode[nmode++] = "--gang";
+    if (c->mold) mode[nmode++] = "--mold";
+    if (c->smp) mode[nmode++] = "--smp";
+    if (c->locks_path[0]) mode[nmode++] = "--locks";
+    if (c->pipeline || c->lockstep) mode[nmode++] = c->pipeline ? "--pipeline" : "--lockstep";
+    if (nmode > 1){ fprintf(stderr,"%s and %s cannot be combined\n", mode[0], mode[1]); exit(1); }
+    bool has_patience = c->patience >= 0;
+    for (int k=0;k<c->ncols;k++) has_patience |= c->cols[k] == COL_PATIENCE;
+    if (has_patience && nmode){ fprintf(stderr,"Patience applies to the plain FCFS/SJF/SRTF/RR runs only\n"); exit(1); }
+    if ((c->until != INT_MAX || c->max_events != LLONG_MAX) && nmode && !c->locks_path[0]){
+        fprintf(stderr,"--until and --max-events apply to the plain runs and --locks only, not %s\n", mode[0]); exit(1);
+    }
+    if (c->norm_prefix[0] && nmode && !(c->cluster || c->locks_path[0] || c->pipeline || c->lockstep || c->exec_alg >= 0 || c->calib_mask)){
+        fprintf(stderr,"%s writes no per-job results for --norm\n", mode[0]); exit(1);
+    }
+    if (c->gittins_path[0] && nmode){ fprintf(stderr,"--gittins runs alongside the plain FCFS/SJF/SRTF/RR engines only\n"); exit(1); }
+    if (c->daemon && (c->exec_alg >= 0 || c->calib_mask || c->replay_alg >= 0 || c->adv_alg[0] >= 0 || c->diff_side[0][0])){
+        fprintf(stderr,"%s cannot be combined with --daemon\n", mode[0]); exit(1);
+    }
+    if (c->machines < 0){ fprintf(stderr,"--machines must be positive\n"); exit(1); }
+    if (c->smp < 0 || c->smp > SMP_MAX){ fprintf(stderr,"--smp expects 1..%d CPUs\n", SMP_MAX); exit(1); }
+    if (c->smp && c->node_algo != 0 && c->node_algo != 1){ fprintf(stderr,"--smp queues are fcfs or sjf\n"); exit(1); }
+    if (c->gang < 0 || c->gang_rows < 1){ fprintf(stderr,"--gang and --gang-rows must be positive\n"); exit(1); }
+    if (c->mold < 0 || c->amdahl < 0 || c->amdahl > 1 || c->fixed_width < 1 || (c->mold && c->fixed_width > c->mold)){
+        fprintf(stderr,"--mold needs P > 0, 0 <= --amdahl <= 1 and 1 <= --fixed-width <= P\n"); exit(1);
+    }
+    if (c->tick_us <= 0 || c->exec_cpu < 0 || c->exec_cpu >= CPU_SETSIZE){ fprintf(stderr,"--tick-us must be > 0 and --exec-cpu a valid CPU\n"); exit(1); }
+    if (c->time_scale <= 0){ fprintf(stderr,"--time-scale must be > 0\n"); exit(1); }
+    if (c->adv_alg[0] >= 0){
+        for (int k=0;k<2;k++) if (c->adv_alg[k] == 3 && !c->adv_q[k]) c->adv_q[k] = c->quantum;
+        if (c->adv_pop < 2 || c->adv_gens < 0){ fprintf(stderr,"--adv-pop must be >= 2 and --adv-gens >= 0\n"); exit(1); }
+        if (c->ncols != 3){ fprintf(stderr,"--adversary reads PID Arrival Burst only\n"); exit(1); }
+    }
+    if (c->diff_side[0][0]){
+        for (int k=0;k<2;k++) if (c->diff_alg[k] == 3 && !c->diff_q[k]) c->diff_q[k] = c->quantum;
+        if (c->diff_top < 0){ fprintf(stderr,"--diff-top must be >= 0\n"); exit(1); }
+    }
+    if (c->smt){
+        bool aff = false;
+        for (int k=0;k<c->ncols;k++) aff |= c->cols[k] == COL_AFFINITY;
+        if (!c->smp || aff){ fprintf(stderr,"--smt needs --smp and no affinity column\n"); exit(1); }
+    }
+    /* a timeline grows with the whole run; streaming keeps only ready queues */
+    if ((c->pipeline || c->lockstep) && !c->gantt_forced) c->print_gantt = false;
+    if ((c->pipeline || c->lockstep) && c->ncols != 3){ fprintf(stderr,"--pipeline/--lockstep read PID Arrival Burst only\n"); exit(1); }
+    if (c->nscale){
+        if (c->cpus_min < 1 || c->cpus_max < c->cpus_min || c->cooldown < 0 || c->provision_delay < 0 || c->util_window <= 0){
+            fprintf(stderr,"Need 1 <= MIN <= MAX CPUs, cooldown/delay >= 0 and a positive utilisation window\n"); exit(1);
+        }
+        if (c->node_algo != 0 && c->node_algo != 1){ fprintf(stderr,"--autoscale queues are fcfs or sjf\n"); exit(1); }
+    }
+    if (c->pipeline && c->run_fcfs + c->run_sjf + c->run_srtf + c->run_rr != 1){ fprintf(stderr,"--pipeline runs exactly one --algo (use --lockstep for several)\n"); exit(1); }
+    if (c->pipeline || c->lockstep){
+        if (!(c->run_fcfs || c->run_sjf || c->run_srtf || c->run_rr)){ fprintf(stderr,"No algorithm selected\n"); exit(1); }
+        if (c->daemon){
+            fprintf(stderr,"--pipeline/--lockstep cannot be combined with --daemon\n"); exit(1);
+        }
+    }
 }
 
 /* ===================== IO helpers ===================== */
@@ -99,41 +674,170 @@ static int read_int(const char *label){
 
 /* ===================== Metrics & CSV ===================== */
 
+/* --norm=PREFIX: the workload goes once to PREFIX_workload.csv
+   (Row,PID,Arrival,Burst) and each algorithm gets PREFIX_<alg>.csv with just
+   Row,Start,Completion (plus Response,Waiting,Turnaround with --norm-derived).
+   Rows are numbered across workloads. Numbers are formatted by hand into
+   64 KiB buffers rather than through fprintf. */
+#define NORM_BUF (1<<16)
+#define NORM_MAX 16
+
+typedef struct { FILE *f; char *b; int len; long long bytes; } OutBuf;
+
+static void ob_open(OutBuf *o, const char *path){
+    o->f = fopen(path, "w");
+    if (!o->f){ fprintf(stderr,"ERROR: cannot open %s for writing\n", path); exit(1); }
+    o->b = (char*)malloc(NORM_BUF);
+    if (!o->b){ fprintf(stderr,"OOM\n"); exit(1); }
+    o->len = 0; o->bytes = 0;
+}
+static void ob_flush(OutBuf *o){ fwrite(o->b, 1, o->len, o->f); o->bytes += o->len; o->len = 0; }
+static void ob_close(OutBuf *o){ ob_flush(o); fclose(o->f); free(o->b); }
+static void ob_str(OutBuf *o, const char *s){
+    for (; *s; s++){ if (o->len == NORM_BUF) ob_flush(o); o->b[o->len++] = *s; }
+}
+static inline void ob_int(OutBuf *o, long long v, char sep){
+    if (o->len > NORM_BUF - 24) ob_flush(o);
+    char tmp[24]; int k = 0;
+    unsigned long long u = v < 0 ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    if (v < 0) o->b[o->len++] = '-';
+    do { tmp[k++] = (char)('0' + u % 10); u /= 10; } while (u);
+    while (k) o->b[o->len++] = tmp[--k];
+    o->b[o->len++] = sep;
+}
+
+/* File-name form of an algorithm label: "RoundRobin(q=2)" -> "RoundRobin_q_2". */
+static void alg_tag(const char *alg, char tag[64]){
+    int k = 0;
+    for (const char *s = alg; *s && k < 63; s++){
+        bool keep = (*s>='a'&&*s<='z') || (*s>='A'&&*s<='Z') || (*s>='0'&&*s<='9');
+        if (keep) tag[k++] = *s; else if (k && tag[k-1] != '_') tag[k++] = '_';
+    }
+    while (k && tag[k-1] == '_') k--;
+    tag[k] = '\0';
+}
+
+typedef struct { char alg[64]; OutBuf o; } NormFile;
+typedef struct {
+    char prefix[256];
+    bool derived;
+    OutBuf wl;
+    NormFile f[NORM_MAX]; int nf;
+    long long row_base;          /* first row of the current workload */
+} Norm;
+
+static void norm_open(Norm *nm, const char *prefix, bool derived){
+    char path[300];
+    snprintf(nm->prefix, sizeof(nm->prefix), "%s", prefix);
+    nm->derived = derived; nm->nf = 0; nm->row_base = 0;
+    snprintf(path, sizeof(path), "%s_workload.csv", prefix);
+    ob_open(&nm->wl, path);
+    ob_str(&nm->wl, "Row,PID,Arrival,Burst\n");
+}
+static OutBuf *norm_file(Norm *nm, const char *alg){
+    for (int i=0;i<nm->nf;i++) if (!strcmp(nm->f[i].alg, alg)) return &nm->f[i].o;
+    if (nm->nf == NORM_MAX){ fprintf(stderr,"ERROR: too many --norm result tables\n"); exit(1); }
+    NormFile *f = &nm->f[nm->nf++];
+    snprintf(f->alg, sizeof(f->alg), "%s", alg);
+    char tag[64], path[340];
+    alg_tag(alg, tag);
+    snprintf(path, sizeof(path), "%s_%s.csv", nm->prefix, tag);
+    ob_open(&f->o, path);
+    ob_str(&f->o, nm->derived ? "Row,Start,Completion,Response,Waiting,Turnaround\n" : "Row,Start,Completion\n");
+    return &f->o;
+}
+static inline void norm_row(const Norm *nm, OutBuf *o, long long row, int arrival, int burst, int start, int end){
+    ob_int(o, row, ','); ob_int(o, start, ',');
+    if (!nm->derived){ ob_int(o, end, '\n'); return; }
+    ob_int(o, end, ','); ob_int(o, start - arrival, ','); ob_int(o, end - arrival - burst, ','); ob_int(o, end - arrival, '\n');
+}
+static void norm_workload(Norm *nm, long long first_row, const Proc *pr, int n){
+    for (int i=0;i<n;i++){
+        ob_int(&nm->wl, first_row + i, ','); ob_int(&nm->wl, pr[i].pid, ',');
+        ob_int(&nm->wl, pr[i].arrival, ','); ob_int(&nm->wl, pr[i].burst, '\n');
+    }
+}
+static long long norm_close(Norm *nm){
+    long long bytes = 0;
+    ob_close(&nm->wl); bytes += nm->wl.bytes;
+    for (int i=0;i<nm->nf;i++){ ob_close(&nm->f[i].o); bytes += nm->f[i].o.bytes; }
+    return bytes;
+}
+
+/* --segments: the coalesced timeline of a run as START END PID lines, the
+   stored form read back by --diff. */
+static void seg_save(const char *prefix, const char *alg, const SegVec *sv){
+    char tag[64], path[340];
+    alg_tag(alg, tag);
+    snprintf(path, sizeof(path), "%s_%s.seg", prefix, tag);
+    OutBuf o; ob_open(&o, path);
+    for (int i=0;i<sv->len;i++){ ob_int(&o, sv->a[i].start, ' '); ob_int(&o, sv->a[i].end, ' '); ob_int(&o, sv->a[i].pid, '\n'); }
+    ob_close(&o);
+}
+
 typedef struct {
     FILE *f;
     bool open;
+    const char *path;            /* opened on the first row, NULL = --no-csv */
+    Norm *norm;                  /* --norm tables, NULL = off */
 } Csv;
 
 static void csv_open(Csv *c, const Config *cfg){
-    if (!cfg->write_csv){ c->open=false; c->f=NULL; return; }
-    c->f = fopen(cfg->csv_path, "w");
-    if (!c->f){ fprintf(stderr,"ERROR: cannot open %s for writing\n", cfg->csv_path); exit(1); }
+    c->norm = NULL;
+    if (cfg->norm_prefix[0]){
+        c->norm = (Norm*)malloc(sizeof(Norm));
+        if (!c->norm){ fprintf(stderr,"OOM\n"); exit(1); }
+        norm_open(c->norm, cfg->norm_prefix, cfg->norm_derived);
+    }
+    c->open = false; c->f = NULL;
+    c->path = cfg->write_csv ? cfg->csv_path : NULL;
+}
+/* The file is created on first use, so modes that write no per-job rows
+   leave an existing CSV alone. */
+static FILE *csv_file(Csv *c){
+    if (c->open) return c->f;
+    c->f = fopen(c->path, "w");
+    if (!c->f){ fprintf(stderr,"ERROR: cannot open %s for writing\n", c->path); exit(1); }
     fprintf(c->f, "Algorithm,PID,Arrival,Burst,Start,Completion,Response,Waiting,Turnaround\n");
     c->open = true;
+    return c->f;
 }
 static void csv_close(Csv *c){ if (c->open){ fclose(c->f); c->open=false; } }
 
 static void csv_dump_algo(Csv *csv, const char *alg, const Proc *pr, int n, const int *start, const int *end){
-    if (!csv->open) return;
+    if (csv->norm){
+        OutBuf *o = norm_file(csv->norm, alg);
+        for (int i=0;i<n;i++) if (end[i] >= 0) norm_row(csv->norm, o, csv->norm->row_base + i, pr[i].arrival, pr[i].burst, start[i], end[i]);
+    }
+    if (!csv->path) return;
+    FILE *f = csv_file(csv);
     for (int i=0;i<n;i++){
+        if (end[i] < 0) continue;   /* unfinished at --until / --max-events */
         int resp = start[i] - pr[i].arrival;
         int tat  = end[i]   - pr[i].arrival;
         int wait = tat - pr[i].burst;
-        fprintf(csv->f, "%s,%d,%d,%d,%d,%d,%d,%d,%d\n",
+        fprintf(f, "%s,%d,%d,%d,%d,%d,%d,%d,%d\n",
                 alg, pr[i].pid, pr[i].arrival, pr[i].burst, start[i], end[i], resp, wait, tat);
     }
 }
 
+static void print_avg_sums(const char *alg, double sr, double sw, double st, long long done){
+    if (!done){ printf("%s Averages: no completed jobs\n\n", alg); return; }
+    printf("%s Averages:\n  Response:  %.2f\n  Waiting :  %.2f\n  Turnaround:%.2f\n\n",
+           alg, sr/done, sw/done, st/done);
+}
+
+/* Averages over completed jobs (all of them unless the run was cut short). */
 static void print_avgs(const char *alg, const Proc *pr, int n, const int *start, const int *end){
-    double sr=0, sw=0, st=0;
+    double sr=0, sw=0, st=0; int done=0;
     for (int i=0;i<n;i++){
+        if (end[i] < 0) continue;
         int resp = start[i] - pr[i].arrival;
         int tat  = end[i]   - pr[i].arrival;
         int wait = tat - pr[i].burst;
-        sr += resp; sw += wait; st += tat;
+        sr += resp; sw += wait; st += tat; done++;
     }
-    printf("%s Averages:\n  Response:  %.2f\n  Waiting :  %.2f\n  Turnaround:%.2f\n\n",
-           alg, sr/n, sw/n, st/n);
+    print_avg_sums(alg, sr, sw, st, done);
 }
 
 /* visuals */
@@ -160,9 +864,394 @@ static void print_pertick(const char *alg, const SegVec *sv, const Config *cfg){
     printf("\n");
 }
 
+/* ===================== Prometheus export ===================== */
+/* Engines count into a stack-local EngineStats and push deltas to the shared
+   registry only every MET_BATCH events (and once at the end), so the per-event
+   cost is an increment plus one compare. Histograms are filled from start/end
+   after the run. A writer thread rewrites the textfile atomically (tmp+rename)
+   and an optional server thread answers GET /metrics on 127.0.0.1. */
+
+#define MET_BATCH (1LL<<16)
+#define MET_NBUCKETS 14
+static const double MET_BUCKETS[MET_NBUCKETS] = {1,2,5,10,20,50,100,200,500,1000,2000,5000,10000,100000};
+
+typedef struct {
+    long long events, dispatches, preemptions, completions, idle;
+    int qdepth, qdepth_max;
+} EngineStats;
+
+typedef struct {
+    char alg[64];
+    long long runs;
+    EngineStats tot;
+    double events_per_sec;
+    long long resp_b[MET_NBUCKETS], tat_b[MET_NBUCKETS], hist_count;
+    double resp_sum, tat_sum;
+} MetAlg;
+
+typedef struct Metrics {
+    pthread_mutex_t mu;
+    MetAlg *a; int len, cap;
+    const Config *cfg;
+    atomic_bool stop;            /* set by metrics_stop, polled by both threads */
+    pthread_t writer, server;
+    bool writer_on, server_on;
+    int listen_fd;
+} Metrics;
+
+/* per-run batching state, lives on the engine's stack */
+typedef struct {
+    Metrics *m; int slot;
+    long long next;            /* st.events value that triggers the next flush */
+    EngineStats sent;          /* what has already been pushed */
+    struct timespec t0, tlast;
+} MetBatch;
+
+static double ts_diff(const struct timespec *a, const struct timespec *b){
+    return (double)(b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+static int met_slot(Metrics *m, const char *alg){
+    for (int i=0;i<m->len;i++) if (!strcmp(m->a[i].alg, alg)) return i;
+    if (m->len == m->cap){
+        int ncap = m->cap ? m->cap*2 : 8;
+        MetAlg *na = (MetAlg*)realloc(m->a, ncap*sizeof(MetAlg));
+        if (!na){ fprintf(stderr,"OOM\n"); exit(1); }
+        m->a = na; m->cap = ncap;
+    }
+    MetAlg *e = &m->a[m->len];
+    memset(e, 0, sizeof(*e));
+    strncpy(e->alg, alg, sizeof(e->alg)-1);
+    return m->len++;
+}
+
+static void met_begin(MetBatch *b, const Config *cfg, const char *alg){
+    memset(b, 0, sizeof(*b));
+    b->m = cfg->metrics;
+    b->next = LLONG_MAX;
+    if (!b->m) return;
+    pthread_mutex_lock(&b->m->mu);
+    b->slot = met_slot(b->m, alg);
+    b->m->a[b->slot].runs++;
+    pthread_mutex_unlock(&b->m->mu);
+    b->next = MET_BATCH;
+    clock_gettime(CLOCK_MONOTONIC, &b->t0);
+    b->tlast = b->t0;
+}
+
+static void met_flush(MetBatch *b, const EngineStats *st){
+    if (!b->m) return;
+    struct timespec now; clock_gettime(CLOCK_MONOTONIC, &now);
+    double dt = ts_diff(&b->tlast, &now);
+    pthread_mutex_lock(&b->m->mu);
+    MetAlg *e = &b->m->a[b->slot];
+    e->tot.events      += st->events      - b->sent.events;
+    e->tot.dispatches  += st->dispatches  - b->sent.dispatches;
+    e->tot.preemptions += st->preemptions - b->sent.preemptions;
+    e->tot.completions += st->completions - b->sent.completions;
+    e->tot.idle        += st->idle        - b->sent.idle;
+    e->tot.qdepth = st->qdepth;
+    if (st->qdepth_max > e->tot.qdepth_max) e->tot.qdepth_max = st->qdepth_max;
+    if (dt > 0) e->events_per_sec = (st->events - b->sent.events) / dt;
+    pthread_mutex_unlock(&b->m->mu);
+    b->sent = *st; b->tlast = now;
+    b->next = st->events + MET_BATCH;
+}
+
+static void met_end(MetBatch *b, EngineStats *st, const Proc *pr, int n, const int *start, const int *end){
+    if (!b->m) return;
+    st->qdepth = 0;
+    met_flush(b, st);
+    long long rb[MET_NBUCKETS]={0}, tb[MET_NBUCKETS]={0}, cnt=0; double rs=0, ts=0;
+    for (int i=0;i<n;i++){
+        if (end[i] < 0) continue;
+        int resp = start[i] - pr[i].arrival, tat = end[i] - pr[i].arrival;
+        for (int k=0;k<MET_NBUCKETS;k++) if (resp <= MET_BUCKETS[k]){ rb[k]++; break; }
+        for (int k=0;k<MET_NBUCKETS;k++) if (tat  <= MET_BUCKETS[k]){ tb[k]++; break; }
+        rs += resp; ts += tat; cnt++;
+    }
+    double wall = ts_diff(&b->t0, &b->tlast);
+    pthread_mutex_lock(&b->m->mu);
+    MetAlg *e = &b->m->a[b->slot];
+    for (int k=0;k<MET_NBUCKETS;k++){ e->resp_b[k] += rb[k]; e->tat_b[k] += tb[k]; }
+    e->hist_count += cnt; e->resp_sum += rs; e->tat_sum += ts;
+    if (wall > 0) e->events_per_sec = st->events / wall;
+    pthread_mutex_unlock(&b->m->mu);
+}
+
+static void met_counter(FILE *f, const Metrics *m, const char *name, const char *help, const char *type, size_t off, bool is_int){
+    fprintf(f, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    for (int i=0;i<m->len;i++){
+        const char *p = (const char*)&m->a[i] + off;
+        if (is_int) fprintf(f, "%s{algorithm=\"%s\"} %lld\n", name, m->a[i].alg, *(const long long*)p);
+        else        fprintf(f, "%s{algorithm=\"%s\"} %.3f\n", name, m->a[i].alg, *(const double*)p);
+    }
+}
+static void met_gauge_int(FILE *f, const Metrics *m, const char *name, const char *help, size_t off){
+    fprintf(f, "# HELP %s %s\n# TYPE %s gauge\n", name, help, name);
+    for (int i=0;i<m->len;i++)
+        fprintf(f, "%s{algorithm=\"%s\"} %d\n", name, m->a[i].alg, *(const int*)((const char*)&m->a[i] + off));
+}
+static void met_histogram(FILE *f, const Metrics *m, const char *name, const char *help, bool resp){
+    fprintf(f, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    for (int i=0;i<m->len;i++){
+        const MetAlg *e = &m->a[i];
+        const long long *b = resp ? e->resp_b : e->tat_b;
+        long long cum = 0;
+        for (int k=0;k<MET_NBUCKETS;k++){
+            cum += b[k];
+            fprintf(f, "%s_bucket{algorithm=\"%s\",le=\"%g\"} %lld\n", name, e->alg, MET_BUCKETS[k], cum);
+        }
+        fprintf(f, "%s_bucket{algorithm=\"%s\",le=\"+Inf\"} %lld\n", name, e->alg, e->hist_count);
+        fprintf(f, "%s_sum{algorithm=\"%s\"} %.0f\n", name, e->alg, resp ? e->resp_sum : e->tat_sum);
+        fprintf(f, "%s_count{algorithm=\"%s\"} %lld\n", name, e->alg, e->hist_count);
+    }
+}
+
+/* Render the exposition text; caller frees. */
+static char *met_render(Metrics *m, size_t *len){
+    char *buf = NULL; FILE *f = open_memstream(&buf, len);
+    if (!f){ fprintf(stderr,"OOM\n"); exit(1); }
+    pthread_mutex_lock(&m->mu);
+    met_counter(f, m, "sched_runs_total", "Simulation runs started.", "counter", offsetof(MetAlg, runs), true);
+    met_counter(f, m, "sched_events_total", "Scheduler events processed.", "counter", offsetof(MetAlg, tot.events), true);
+    met_counter(f, m, "sched_dispatches_total", "Dispatch decisions.", "counter", offsetof(MetAlg, tot.dispatches), true);
+    met_counter(f, m, "sched_preemptions_total", "Preemptions of a runnable job.", "counter", offsetof(MetAlg, tot.preemptions), true);
+    met_counter(f, m, "sched_jobs_completed_total", "Jobs completed.", "counter", offsetof(MetAlg, tot.completions), true);
+    met_counter(f, m, "sched_idle_time_total", "Simulated CPU idle time units.", "counter", offsetof(MetAlg, tot.idle), true);
+    met_counter(f, m, "sched_events_per_second", "Simulator throughput over the last batch.", "gauge", offsetof(MetAlg, events_per_sec), false);
+    met_gauge_int(f, m, "sched_queue_depth", "Ready-queue depth at the last flush.", offsetof(MetAlg, tot.qdepth));
+    met_gauge_int(f, m, "sched_queue_depth_max", "Maximum ready-queue depth observed.", offsetof(MetAlg, tot.qdepth_max));
+    met_histogram(f, m, "sched_response_time", "Per-job response time (start - arrival).", true);
+    met_histogram(f, m, "sched_turnaround_time", "Per-job turnaround time (completion - arrival).", false);
+    pthread_mutex_unlock(&m->mu);
+    fclose(f);
+    return buf;
+}
+
+static void met_write_file(Metrics *m){
+    const char *path = m->cfg->metrics_path;
+    if (!path[0]) return;
+    char tmp[300]; snprintf(tmp, sizeof(tmp), "%s.tmp.%d", path, (int)getpid());
+    size_t len; char *buf = met_render(m, &len);
+    FILE *f = fopen(tmp, "w");
+    if (!f){ fprintf(stderr,"WARNING: cannot write %s\n", tmp); free(buf); return; }
+    bool ok = fwrite(buf, 1, len, f) == len;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp, path) != 0){ fprintf(stderr,"WARNING: metrics export to %s failed\n", path); remove(tmp); }
+    free(buf);
+}
+
+static void *met_writer_main(void *arg){
+    Metrics *m = (Metrics*)arg;
+    while (!atomic_load(&m->stop)){
+        for (int i=0; i<m->cfg->metrics_interval*10 && !atomic_load(&m->stop); i++){
+            struct timespec ts = {0, 100*1000*1000}; nanosleep(&ts, NULL);
+        }
+        met_write_file(m);
+    }
+    return NULL;
+}
+
+#define MET_CLIENTS 16          /* connections read at once */
+#define MET_CLIENT_MS 2000      /* a client must send its request line within this */
+
+typedef struct { int fd, len; struct timespec t0; char req[1024]; } MetClient;
+
+static void met_reply(Metrics *m, MetClient *cl){
+    int c = cl->fd;
+    cl->req[cl->len] = '\0';
+    /* the reply goes out blocking, bounded by a send timeout */
+    struct timeval tv = { MET_CLIENT_MS / 1000, MET_CLIENT_MS % 1000 * 1000 };
+    if (fcntl(c, F_SETFL, fcntl(c, F_GETFL) & ~O_NONBLOCK) != 0 || setsockopt(c, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) != 0) return;
+    if (!strncmp(cl->req, "GET /metrics", 12)){
+        size_t len; char *body = met_render(m, &len);
+        char hdr[160];
+        int hl = snprintf(hdr, sizeof(hdr), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\n\r\n", len);
+        if (send(c, hdr, hl, MSG_NOSIGNAL) == hl) (void)send(c, body, len, MSG_NOSIGNAL);
+        free(body);
+    } else {
+        static const char nf[] = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        (void)send(c, nf, sizeof(nf)-1, MSG_NOSIGNAL);
+    }
+}
+
+/* One thread serves everything: accepted sockets are non-blocking and polled
+   together with the listener, and a client that has not sent a full request
+   line within MET_CLIENT_MS is dropped, so an idle connection can neither
+   stall other scrapes nor hold up metrics_stop. */
+static void *met_server_main(void *arg){
+    Metrics *m = (Metrics*)arg;
+    MetClient cl[MET_CLIENTS]; int ncl = 0;
+    while (!atomic_load(&m->stop)){
+        struct pollfd pfd[MET_CLIENTS + 1];
+        pfd[0] = (struct pollfd){ .fd = ncl < MET_CLIENTS ? m->listen_fd : -1, .events = POLLIN };
+        for (int k=0;k<ncl;k++) pfd[k+1] = (struct pollfd){ .fd = cl[k].fd, .events = POLLIN };
+        if (poll(pfd, ncl + 1, 200) < 0 && errno != EINTR) break;
+        struct timespec now; clock_gettime(CLOCK_MONOTONIC, &now);
+        for (int k=ncl-1;k>=0;k--){
+            bool done = false, drop = ts_diff(&cl[k].t0, &now) * 1e3 > MET_CLIENT_MS;
+            if (pfd[k+1].revents){
+                ssize_t r = recv(cl[k].fd, cl[k].req + cl[k].len, sizeof(cl[k].req) - 1 - cl[k].len, 0);
+                if (r > 0){
+                    cl[k].len += (int)r;
+                    done = memchr(cl[k].req, '\n', cl[k].len) || cl[k].len == (int)sizeof(cl[k].req) - 1;
+                } else if (r == 0 || (errno != EAGAIN && errno != EINTR)) drop = true;
+            }
+            if (done) met_reply(m, &cl[k]);
+            if (done || drop){ close(cl[k].fd); cl[k] = cl[--ncl]; }
+        }
+        if (pfd[0].revents & POLLIN){
+            int c = accept(m->listen_fd, NULL, NULL);
+            if (c < 0) continue;
+            if (fcntl(c, F_SETFL, fcntl(c, F_GETFL) | O_NONBLOCK) != 0){ close(c); continue; }
+            cl[ncl].fd = c; cl[ncl].len = 0; cl[ncl].t0 = now; ncl++;
+        }
+    }
+    for (int k=0;k<ncl;k++) close(cl[k].fd);
+    return NULL;
+}
+
+static void metrics_start(Metrics *m, const Config *cfg){
+    memset(m, 0, sizeof(*m));
+    atomic_init(&m->stop, false);
+    pthread_mutex_init(&m->mu, NULL);
+    m->cfg = cfg; m->listen_fd = -1;
+    if (cfg->metrics_path[0]){
+        if (pthread_create(&m->writer, NULL, met_writer_main, m) != 0){ fprintf(stderr,"ERROR: cannot start metrics writer\n"); exit(1); }
+        m->writer_on = true;
+    }
+    if (cfg->metrics_port){
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1; setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in sa; memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET; sa.sin_port = htons((unsigned short)cfg->metrics_port);
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (fd < 0 || bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, 16) != 0){
+            fprintf(stderr,"ERROR: cannot listen on 127.0.0.1:%d: %s\n", cfg->metrics_port, strerror(errno)); exit(1);
+        }
+        m->listen_fd = fd;
+        if (pthread_create(&m->server, NULL, met_server_main, m) != 0){ fprintf(stderr,"ERROR: cannot start metrics server\n"); exit(1); }
+        m->server_on = true;
+    }
+}
+
+static void metrics_stop(Metrics *m){
+    atomic_store(&m->stop, true);
+    if (m->writer_on) pthread_join(m->writer, NULL);
+    if (m->server_on) pthread_join(m->server, NULL);
+    if (m->listen_fd >= 0) close(m->listen_fd);
+    met_write_file(m);   /* final snapshot */
+    pthread_mutex_destroy(&m->mu);
+    free(m->a);
+}
+
+/* ===================== Decision audit log ===================== */
+/* Fixed-size records in native byte order behind a 16-byte header, written
+   through a private 1 MiB buffer so an enabled log costs a struct copy per
+   decision; decode the log on a machine of the same endianness.
+   Key meaning per algorithm: FCFS arrival, SJF burst, SRTF remaining time,
+   RR remaining time (the RR order itself is queue position; the runner-up
+   is the job at position 1), Gittins index in millionths. */
+
+#define AUD_MAGIC "SCHDAUD1"
+#define AUD_BUFSZ (1<<20)
+
+enum { AUD_RUN=0, AUD_DISPATCH=1, AUD_PREEMPT=2, AUD_COMPLETE=3, AUD_ABANDON=4 };
+enum { ALG_FCFS=0, ALG_SJF=1, ALG_SRTF=2, ALG_RR=3, ALG_GITTINS=4 };   /* Gittins: --gittins runs and audit records only */
+
+typedef struct {
+    uint8_t type, alg; uint16_t reserved;
+    int32_t time;
+    int32_t pid, runner;         /* runner = -1 when nothing else was ready */
+    int32_t key, runner_key;     /* compared values, see above */
+    int32_t depth;               /* ready-queue depth at the decision */
+} AuditRec;
+
+typedef struct Audit {
+    FILE *f;
+    unsigned char *buf; size_t len;
+    long long records;
+} Audit;
+
+static void audit_open(Audit *a, const char *path){
+    a->f = fopen(path, "wb");
+    if (!a->f){ fprintf(stderr,"ERROR: cannot open %s for writing\n", path); exit(1); }
+    a->buf = (unsigned char*)malloc(AUD_BUFSZ);
+    if (!a->buf){ fprintf(stderr,"OOM\n"); exit(1); }
+    a->len = 0; a->records = 0;
+    unsigned char hdr[16] = AUD_MAGIC;
+    uint32_t recsz = sizeof(AuditRec);
+    memcpy(hdr+8, &recsz, 4);
+    if (fwrite(hdr, 1, sizeof(hdr), a->f) != sizeof(hdr)){ fprintf(stderr,"ERROR: audit log write failed\n"); exit(1); }
+}
+static void audit_flush(Audit *a){
+    if (a->len && fwrite(a->buf, 1, a->len, a->f) != a->len){ fprintf(stderr,"ERROR: audit log write failed\n"); exit(1); }
+    a->len = 0;
+}
+static void audit_close(Audit *a){
+    audit_flush(a);
+    if (fclose(a->f) != 0){ fprintf(stderr,"ERROR: audit log write failed\n"); exit(1); }
+    free(a->buf);
+}
+
+static inline void audit_emit(Audit *a, int type, int alg, int time, int pid, int runner, int key, int runner_key, int depth){
+    if (a->len + sizeof(AuditRec) > AUD_BUFSZ) audit_flush(a);
+    AuditRec r = { (uint8_t)type, (uint8_t)alg, 0, time, pid, runner, key, runner_key, depth };
+    memcpy(a->buf + a->len, &r, sizeof(r));
+    a->len += sizeof(r); a->records++;
+}
+
+/* `sched decode-audit FILE`: print one line per record plus totals. */
+static int audit_decode(const char *path){
+    static const char *ALGS[] = {"FCFS","SJF","SRTF","RR","Gittins"};
+    static const char *KEYS[] = {"arrival","burst","remaining","remaining","index"};
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f){ fprintf(stderr,"ERROR: cannot open audit log %s\n", path ? path : "(none)"); return 1; }
+    unsigned char hdr[16]; uint32_t recsz = 0;
+    if (fread(hdr, 1, 16, f) != 16 || memcmp(hdr, AUD_MAGIC, 8) != 0){ fprintf(stderr,"ERROR: %s is not an audit log\n", path); fclose(f); return 1; }
+    memcpy(&recsz, hdr+8, 4);
+    if (recsz != sizeof(AuditRec)){ fprintf(stderr,"ERROR: unsupported record size %u\n", recsz); fclose(f); return 1; }
+    long long cnt[5] = {0};
+    AuditRec r; int alg = 0;
+    while (fread(&r, sizeof(r), 1, f) == 1){
+        if (r.type > AUD_ABANDON || r.alg > ALG_GITTINS){ fprintf(stderr,"ERROR: corrupt record\n"); fclose(f); return 1; }
+        cnt[r.type]++; alg = r.alg;
+        switch (r.type){
+        case AUD_RUN:
+            if (alg == ALG_RR) printf("== %s q=%d n=%d\n", ALGS[alg], r.key, r.pid);
+            else               printf("== %s n=%d\n", ALGS[alg], r.pid);
+            break;
+        case AUD_DISPATCH:
+            if (alg == ALG_GITTINS){
+                printf("t=%d DISPATCH P%d index=%.6f", r.time, r.pid, r.key / 1e6);
+                if (r.runner >= 0) printf(" over P%d index=%.6f", r.runner, r.runner_key / 1e6);
+            } else {
+                printf("t=%d DISPATCH P%d %s=%d", r.time, r.pid, KEYS[alg], r.key);
+                if (r.runner >= 0) printf(" over P%d %s=%d", r.runner, KEYS[alg], r.runner_key);
+            }
+            printf(" depth=%d\n", r.depth);
+            break;
+        case AUD_PREEMPT:
+            if (alg == ALG_GITTINS) printf("t=%d PREEMPT P%d remaining=%d by P%d index=%.6f depth=%d\n", r.time, r.pid, r.key, r.runner, r.runner_key / 1e6, r.depth);
+            else printf("t=%d PREEMPT P%d remaining=%d by P%d %s=%d depth=%d\n", r.time, r.pid, r.key, r.runner, KEYS[alg], r.runner_key, r.depth);
+            break;
+        case AUD_COMPLETE:
+            printf("t=%d COMPLETE P%d burst=%d\n", r.time, r.pid, r.key);
+            break;
+        case AUD_ABANDON:
+            printf("t=%d ABANDON P%d waited=%d\n", r.time, r.pid, r.key);
+            break;
+        }
+    }
+    fclose(f);
+    printf("records: runs=%lld dispatch=%lld preempt=%lld complete=%lld abandon=%lld\n", cnt[0], cnt[1], cnt[2], cnt[3], cnt[4]);
+    return 0;
+}
+
 /* ===================== Sorting helpers ===================== */
-/* Portable qsort comparator using a global context (safe in this single-threaded tool). */
-static const Proc *g_pr_sort = NULL;
+/* Portable qsort comparator using a thread-local context (search workers sort concurrently). */
+static _Thread_local const Proc *g_pr_sort = NULL;
 static int cmp_arrival_pid_index(const void *pa, const void *pb){
     int ia = *(const int*)pa, ib = *(const int*)pb;
     const Proc *pr = g_pr_sort;
@@ -171,6 +1260,20 @@ static int cmp_arrival_pid_index(const void *pa, const void *pb){
     return 0;
 }
 
+/* Row indices in (arrival, pid) order; skips the sort when the input is
+   already ordered, which is the common case for traces. */
+static int *arrival_order(const Proc *pr, int n){
+    int *ord = (int*)malloc((n ? n : 1)*sizeof(int));
+    if (!ord){ fprintf(stderr,"OOM\n"); exit(1); }
+    bool sorted = true;
+    for (int i=0;i<n;i++){
+        ord[i] = i;
+        if (i && (pr[i].arrival < pr[i-1].arrival || (pr[i].arrival == pr[i-1].arrival && pr[i].pid < pr[i-1].pid))) sorted = false;
+    }
+    if (!sorted){ g_pr_sort = pr; qsort(ord, n, sizeof(int), cmp_arrival_pid_index); }
+    return ord;
+}
+
 /* ===================== Min-heaps ===================== */
 
 typedef struct {
@@ -229,139 +1332,256 @@ static int heap_pop_srtf(Heap *hp, const Proc *pr, const int *rem){
 
 /* ===================== Algorithms ===================== */
 
-static void run_fcfs(const Proc *pr, int n, Csv *csv, const Config *cfg){
-    const char *ALG = "FCFS";
-    int *idx = (int*)malloc(n*sizeof(int));
-    int *start=(int*)malloc(n*sizeof(int)), *end=(int*)malloc(n*sizeof(int));
-    if(!idx||!start||!end){fprintf(stderr,"OOM\n");exit(1);}
-    for (int i=0;i<n;i++) idx[i]=i;
+/* The sim_* cores fill a SimOut; run_* wrap them with printing and CSV
+   output. --until / --max-events are checked once per engine step: the
+   time horizon is folded into the next-event computation, so the hot loop
+   only gains one combined compare. */
+
+typedef struct {
+    int *start, *end;   /* n entries each; -1 = not started / not finished */
+    int *left;          /* optional: remaining work per job at the stop time */
+    SegVec *sv;         /* optional: timeline */
+    int stop;           /* simulated time when the engine stopped */
+    bool truncated;     /* stopped by --until or --max-events */
+} SimOut;
 
+/* end[] value of a job that gave up waiting (--patience); it never ran.
+   Engines check patience lazily, when the job would be dispatched: a job
+   that has not started by then is dropped, which is exact because a waiting
+   job affects nobody else until it is picked. */
+#define JOB_ABANDONED (-2)
+
+static inline int job_patience(const Config *cfg, int i){
+    return cfg->ext && cfg->ext->v[COL_PATIENCE] ? cfg->ext->v[COL_PATIENCE][i] : cfg->patience;
+}
+static inline bool job_abandons(const Config *cfg, const Proc *pr, int i, int t){
+    int p = job_patience(cfg, i);
+    return p >= 0 && (long long)t > (long long)pr[i].arrival + p;
+}
+/* Abandoned, or (in a truncated run) still queued past its patience. */
+static inline bool job_gone(const Config *cfg, const Proc *pr, const SimOut *o, int i){
+    if (o->end[i] == JOB_ABANDONED) return true;
+    return o->truncated && cfg->reneging && o->end[i] < 0 && o->start[i] < 0 && job_abandons(cfg, pr, i, o->stop);
+}
+
+static void simout_init(SimOut *o, int *start, int *end, int *left, SegVec *sv){
+    o->start = start; o->end = end; o->left = left; o->sv = sv;
+    o->stop = 0; o->truncated = false;
+}
+
+static void print_partial(const Proc *pr, int n, const SimOut *o, const Config *cfg){
+    long long done=0, insys=0, started=0, work=0, future=0, fwork=0;
+    for (int i=0;i<n;i++){
+        if (o->end[i] >= 0) done++;
+        else if (job_gone(cfg, pr, o, i)) continue;
+        else if (pr[i].arrival <= o->stop){ insys++; started += o->start[i] >= 0; work += o->left[i]; }
+        else { future++; fwork += pr[i].burst; }
+    }
+    printf("  Stopped at t=%d: %lld completed; %lld in system (%lld started) with %lld work left; %lld not yet arrived (%lld work)\n\n",
+           o->stop, done, insys, started, work, future, fwork);
+}
+
+static void sim_fcfs(const Proc *pr, int n, const Config *cfg, SimOut *o){
+    const char *ALG = "FCFS";
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events;
+    for (int i=0;i<n;i++){ start[i]=-1; end[i]=-1; }
     /* sort by (arrival, pid) */
-    g_pr_sort = pr;
-    qsort(idx, n, sizeof(int), cmp_arrival_pid_index);
+    int *idx = arrival_order(pr, n);
 
-    SegVec sv={0};
-    int t=0;
-    for (int k=0;k<n;k++){
+    EngineStats st={0}; MetBatch mb; met_begin(&mb, cfg, ALG);
+    Audit *au = cfg->audit;
+    if (au) audit_emit(au, AUD_RUN, ALG_FCFS, 0, n, -1, 0, 0, 0);
+    int t=0, arrived=0, k=0;
+    for (k=0;k<n;k++){
         int i = idx[k];
-        if (t < pr[i].arrival){ seg_push(&sv, (Seg){.pid=-1,.start=t,.end=pr[i].arrival}); t = pr[i].arrival; }
+        if (t >= lim_t || st.events >= lim_ev) break;
+        if (t < pr[i].arrival){
+            int to = pr[i].arrival < lim_t ? pr[i].arrival : lim_t;
+            seg_push(sv, (Seg){.pid=-1,.start=t,.end=to}); st.idle += to - t; t = to;
+            if (t >= lim_t) break;
+        }
+        if (cfg->reneging && job_abandons(cfg, pr, i, t)){
+            end[i] = JOB_ABANDONED;
+            if (au) audit_emit(au, AUD_ABANDON, ALG_FCFS, pr[i].arrival + job_patience(cfg, i), pr[i].pid, -1, job_patience(cfg, i), 0, 0);
+            continue;
+        }
         start[i]=t;
-        seg_push(&sv, (Seg){.pid=pr[i].pid,.start=t,.end=t+pr[i].burst});
+        if (au){
+            while (arrived<n && pr[idx[arrived]].arrival <= t) arrived++;
+            int r = (k+1<n && pr[idx[k+1]].arrival <= t) ? idx[k+1] : -1;
+            audit_emit(au, AUD_DISPATCH, ALG_FCFS, t, pr[i].pid, r<0 ? -1 : pr[r].pid, pr[i].arrival, r<0 ? 0 : pr[r].arrival, arrived - k);
+        }
+        if (pr[i].burst > lim_t - t){    /* horizon cuts this job */
+            seg_push(sv, (Seg){.pid=pr[i].pid,.start=t,.end=lim_t});
+            t = lim_t; st.dispatches++;
+            break;
+        }
+        seg_push(sv, (Seg){.pid=pr[i].pid,.start=t,.end=t+pr[i].burst});
         t += pr[i].burst;
         end[i]=t;
+        if (au) audit_emit(au, AUD_COMPLETE, ALG_FCFS, t, pr[i].pid, -1, pr[i].burst, 0, 0);
+        while (arrived<n && pr[idx[arrived]].arrival <= t) arrived++;
+        st.qdepth = arrived - k - 1; if (st.qdepth > st.qdepth_max) st.qdepth_max = st.qdepth;
+        st.dispatches++; st.completions++;
+        if ((st.events += 2) >= mb.next) met_flush(&mb, &st);
     }
-    seg_coalesce(&sv);
-
-    printf("\nFCFS (FIFO) Scheduling =>\n");
-    print_gantt(ALG, &sv, cfg);
-    print_pertick(ALG, &sv, cfg);
-    print_avgs(ALG, pr, n, start, end);
-    csv_dump_algo(csv, ALG, pr, n, start, end);
-
-    seg_free(&sv); free(idx); free(start); free(end);
+    o->stop = t; o->truncated = k < n;
+    if (o->truncated && o->left){
+        for (int j=0;j<n;j++) o->left[j] = end[j] != -1 ? 0 : pr[j].burst;
+        if (start[idx[k]] >= 0) o->left[idx[k]] = start[idx[k]] + pr[idx[k]].burst - t;
+    }
+    met_end(&mb, &st, pr, n, start, end);
+    seg_coalesce(sv);
+    free(idx);
 }
 
-static void run_sjf(const Proc *pr, int n, Csv *csv, const Config *cfg){
+static void sim_sjf(const Proc *pr, int n, const Config *cfg, SimOut *o){
     const char *ALG = "SJF";
-    int *start=(int*)malloc(n*sizeof(int)), *end=(int*)malloc(n*sizeof(int));
-    if(!start||!end){fprintf(stderr,"OOM\n");exit(1);}
-
-    int *ord = (int*)malloc(n*sizeof(int));
-    for (int i=0;i<n;i++) ord[i]=i;
-    g_pr_sort = pr;
-    qsort(ord, n, sizeof(int), cmp_arrival_pid_index);
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events;
+    for (int i=0;i<n;i++){ start[i]=-1; end[i]=-1; }
+    int *ord = arrival_order(pr, n);
 
     Heap hp; heap_init(&hp, n);
-    SegVec sv={0};
-    int t = 0, k = 0, doneCnt=0;
+    EngineStats st={0}; MetBatch mb; met_begin(&mb, cfg, ALG);
+    Audit *au = cfg->audit;
+    if (au) audit_emit(au, AUD_RUN, ALG_SJF, 0, n, -1, 0, 0, 0);
+    int t = 0, k = 0, doneCnt=0, cut=-1;
 
-    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival;
+    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival < lim_t ? pr[ord[0]].arrival : lim_t;
 
     while (doneCnt < n){
-        while (k<n && pr[ord[k]].arrival <= t){ heap_push_sjf(&hp, pr, ord[k]); k++; }
+        if (t >= lim_t || st.events >= lim_ev) break;
+        while (k<n && pr[ord[k]].arrival <= t){ heap_push_sjf(&hp, pr, ord[k]); k++; st.events++; }
+        if (hp.sz > st.qdepth_max) st.qdepth_max = hp.sz;
         if (hp.sz==0){
             if (k<n){
-                if (t < pr[ord[k]].arrival) seg_push(&sv,(Seg){.pid=-1,.start=t,.end=pr[ord[k]].arrival});
-                t = pr[ord[k]].arrival;
+                int to = pr[ord[k]].arrival < lim_t ? pr[ord[k]].arrival : lim_t;
+                if (t < to){ seg_push(sv,(Seg){.pid=-1,.start=t,.end=to}); st.idle += to - t; }
+                t = to;
                 continue;
             } else break;
         }
+        int depth = hp.sz;
         int i = heap_pop_sjf(&hp, pr);
+        if (cfg->reneging && job_abandons(cfg, pr, i, t)){
+            end[i] = JOB_ABANDONED; doneCnt++;
+            if (au) audit_emit(au, AUD_ABANDON, ALG_SJF, pr[i].arrival + job_patience(cfg, i), pr[i].pid, -1, job_patience(cfg, i), 0, 0);
+            continue;
+        }
         start[i] = t;
-        seg_push(&sv, (Seg){.pid=pr[i].pid,.start=t,.end=t+pr[i].burst});
+        if (au){
+            int r = hp.sz ? hp.h[0] : -1;
+            audit_emit(au, AUD_DISPATCH, ALG_SJF, t, pr[i].pid, r<0 ? -1 : pr[r].pid, pr[i].burst, r<0 ? 0 : pr[r].burst, depth);
+        }
+        if (pr[i].burst > lim_t - t){    /* horizon cuts this job */
+            seg_push(sv, (Seg){.pid=pr[i].pid,.start=t,.end=lim_t});
+            t = lim_t; cut = i; st.dispatches++;
+            break;
+        }
+        seg_push(sv, (Seg){.pid=pr[i].pid,.start=t,.end=t+pr[i].burst});
         t += pr[i].burst;
         end[i] = t; doneCnt++;
+        if (au) audit_emit(au, AUD_COMPLETE, ALG_SJF, t, pr[i].pid, -1, pr[i].burst, 0, 0);
+        st.dispatches++; st.completions++; st.qdepth = hp.sz;
+        if (++st.events >= mb.next) met_flush(&mb, &st);
     }
-    seg_coalesce(&sv);
-
-    printf("SJF (Non-preemptive) Scheduling =>\n");
-    print_gantt(ALG, &sv, cfg);
-    print_pertick(ALG, &sv, cfg);
-    print_avgs(ALG, pr, n, start, end);
-    csv_dump_algo(csv, ALG, pr, n, start, end);
-
-    seg_free(&sv); heap_free(&hp); free(ord); free(start); free(end);
+    o->stop = t; o->truncated = doneCnt < n;
+    if (o->truncated && o->left){
+        for (int j=0;j<n;j++) o->left[j] = end[j] != -1 ? 0 : pr[j].burst;
+        if (cut >= 0) o->left[cut] = start[cut] + pr[cut].burst - t;
+    }
+    met_end(&mb, &st, pr, n, start, end);
+    seg_coalesce(sv);
+    heap_free(&hp); free(ord);
 }
 
-static void run_srtf(const Proc *pr, int n, Csv *csv, const Config *cfg){
+static void sim_srtf(const Proc *pr, int n, const Config *cfg, SimOut *o){
     const char *ALG = "SRTF";
-    int *start=(int*)malloc(n*sizeof(int)), *end=(int*)malloc(n*sizeof(int)), *rem=(int*)malloc(n*sizeof(int));
-    if(!start||!end||!rem){fprintf(stderr,"OOM\n");exit(1);}
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events;
+    int *rem = o->left ? o->left : (int*)malloc(n*sizeof(int));
+    if(!rem){fprintf(stderr,"OOM\n");exit(1);}
     for (int i=0;i<n;i++){ start[i]=-1; end[i]=-1; rem[i]=pr[i].burst; }
 
-    int *ord = (int*)malloc(n*sizeof(int));
-    for (int i=0;i<n;i++) ord[i]=i;
-    g_pr_sort = pr;
-    qsort(ord, n, sizeof(int), cmp_arrival_pid_index);
+    int *ord = arrival_order(pr, n);
 
     Heap hp; heap_init(&hp, n);
-    SegVec sv={0};
+    EngineStats st={0}; MetBatch mb; met_begin(&mb, cfg, ALG);
 
     int t=0, k=0, completed=0;
-    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival;
+    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival < lim_t ? pr[ord[0]].arrival : lim_t;
 
     int cur = -2; int seg_start = t;
+    int last = -1; /* index of the job that ran last, for preemption counting */
+    Audit *au = cfg->audit;
+    if (au) audit_emit(au, AUD_RUN, ALG_SRTF, 0, n, -1, 0, 0, 0);
 
     while (completed < n){
-        while (k<n && pr[ord[k]].arrival <= t){ heap_push_srtf(&hp, pr, rem, ord[k]); k++; }
+        if (t >= lim_t || st.events >= lim_ev) break;
+        while (k<n && pr[ord[k]].arrival <= t){ heap_push_srtf(&hp, pr, rem, ord[k]); k++; st.events++; }
+        if (hp.sz > st.qdepth_max) st.qdepth_max = hp.sz;
         if (hp.sz==0){
             if (k<n){
-                if (cur!=-1){ if (cur!=-2) seg_push(&sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur=-1; seg_start=t; }
-                seg_push(&sv,(Seg){.pid=-1,.start=t,.end=pr[ord[k]].arrival});
-                t = pr[ord[k]].arrival;
+                int to = pr[ord[k]].arrival < lim_t ? pr[ord[k]].arrival : lim_t;
+                if (cur!=-1){ if (cur!=-2) seg_push(sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur=-1; seg_start=t; }
+                seg_push(sv,(Seg){.pid=-1,.start=t,.end=to});
+                st.idle += to - t;
+                t = to;
                 cur = -2; seg_start = t;
                 continue;
             } else break;
         }
         int i = hp.h[0]; /* peek current shortest remaining */
+        if (start[i]==-1 && cfg->reneging && job_abandons(cfg, pr, i, t)){
+            (void)heap_pop_srtf(&hp, pr, rem);
+            end[i] = JOB_ABANDONED; rem[i] = 0; completed++;
+            if (au) audit_emit(au, AUD_ABANDON, ALG_SRTF, pr[i].arrival + job_patience(cfg, i), pr[i].pid, -1, job_patience(cfg, i), 0, 0);
+            continue;
+        }
         if (start[i]==-1) start[i]=t;
+        if (i != last){
+            st.dispatches++;
+            if (last >= 0 && rem[last] > 0){
+                st.preemptions++;
+                if (au) audit_emit(au, AUD_PREEMPT, ALG_SRTF, t, pr[last].pid, pr[i].pid, rem[last], rem[i], hp.sz);
+            }
+            if (au){
+                int r = -1;
+                if (hp.sz > 1) r = hp.h[1];
+                if (hp.sz > 2 && less_srtf(pr, rem, hp.h[2], r)) r = hp.h[2];
+                audit_emit(au, AUD_DISPATCH, ALG_SRTF, t, pr[i].pid, r<0 ? -1 : pr[r].pid, rem[i], r<0 ? 0 : rem[r], hp.sz);
+            }
+            last = i;
+        }
+        st.qdepth = hp.sz;
+        if (++st.events >= mb.next) met_flush(&mb, &st);
 
         int next_arrival = (k<n) ? pr[ord[k]].arrival : INT_MAX;
+        if (next_arrival > lim_t) next_arrival = lim_t;   /* the horizon acts as a final arrival */
         int finish_time  = t + rem[i];
 
         if (finish_time <= next_arrival){
-            if (cur != pr[i].pid){ if (cur!=-2) seg_push(&sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur = pr[i].pid; seg_start=t; }
+            if (cur != pr[i].pid){ if (cur!=-2) seg_push(sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur = pr[i].pid; seg_start=t; }
             t = finish_time; rem[i]=0;
             (void)heap_pop_srtf(&hp, pr, rem);
-            end[i]=t; completed++;
+            end[i]=t; completed++; st.completions++;
+            if (au) audit_emit(au, AUD_COMPLETE, ALG_SRTF, t, pr[i].pid, -1, pr[i].burst, 0, 0);
         } else {
             int run_len = next_arrival - t;
-            if (cur != pr[i].pid){ if (cur!=-2) seg_push(&sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur = pr[i].pid; seg_start=t; }
+            if (cur != pr[i].pid){ if (cur!=-2) seg_push(sv,(Seg){.pid=cur,.start=seg_start,.end=t}); cur = pr[i].pid; seg_start=t; }
             t += run_len; rem[i] -= run_len;
             (void)heap_pop_srtf(&hp, pr, rem);
             heap_push_srtf(&hp, pr, rem, i);
         }
     }
-    if (cur!=-2) seg_push(&sv,(Seg){.pid=cur,.start=seg_start,.end=t});
-    seg_coalesce(&sv);
-
-    printf("SRTF (Preemptive SJF) Scheduling =>\n");
-    print_gantt(ALG, &sv, cfg);
-    print_pertick(ALG, &sv, cfg);
-    print_avgs(ALG, pr, n, start, end);
-    csv_dump_algo(csv, ALG, pr, n, start, end);
-
-    seg_free(&sv); heap_free(&hp); free(ord); free(start); free(end); free(rem);
+    if (cur!=-2) seg_push(sv,(Seg){.pid=cur,.start=seg_start,.end=t});
+    o->stop = t; o->truncated = completed < n;
+    met_end(&mb, &st, pr, n, start, end);
+    seg_coalesce(sv);
+    heap_free(&hp); free(ord);
+    if (rem != o->left) free(rem);
 }
 
 /* Simple circular queue for RR */
@@ -372,96 +1592,3413 @@ static void q_push(Queue *q,int v){ if(q->size==q->cap){fprintf(stderr,"Queue ov
 static int q_pop(Queue *q){ if(q_empty(q)){fprintf(stderr,"Queue underflow\n");exit(1);} int v=q->q[q->front]; q->front=(q->front+1)%q->cap; q->size--; return v; }
 static void q_free(Queue *q){ free(q->q); }
 
-static void run_rr(const Proc *pr, int n, int quantum, Csv *csv, const Config *cfg){
+static void sim_rr(const Proc *pr, int n, int quantum, const Config *cfg, SimOut *o){
     char ALG[64]; snprintf(ALG,sizeof(ALG),"RoundRobin(q=%d)",quantum);
-    int *start=(int*)malloc(n*sizeof(int)), *end=(int*)malloc(n*sizeof(int)), *rem=(int*)malloc(n*sizeof(int)), *inq=(int*)calloc(n,sizeof(int));
-    if(!start||!end||!rem||!inq){fprintf(stderr,"OOM\n");exit(1);}
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events;
+    int *rem = o->left ? o->left : (int*)malloc(n*sizeof(int)), *inq=(int*)calloc(n,sizeof(int));
+    if(!rem||!inq){fprintf(stderr,"OOM\n");exit(1);}
     for (int i=0;i<n;i++){ start[i]=-1; end[i]=-1; rem[i]=pr[i].burst; }
 
-    int *ord = (int*)malloc(n*sizeof(int)); for(int i=0;i<n;i++) ord[i]=i;
-    g_pr_sort = pr;
-    qsort(ord, n, sizeof(int), cmp_arrival_pid_index);
+    int *ord = arrival_order(pr, n);
 
     Queue q; q_init(&q, n);
-    SegVec sv={0};
+    EngineStats st={0}; MetBatch mb; met_begin(&mb, cfg, ALG);
+    Audit *au = cfg->audit;
+    if (au) audit_emit(au, AUD_RUN, ALG_RR, 0, n, -1, quantum, 0, 0);
 
     int t=0, k=0, completed=0;
-    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival;
+    if (n>0 && pr[ord[0]].arrival>t) t = pr[ord[0]].arrival < lim_t ? pr[ord[0]].arrival : lim_t;
 
     while (k<n && pr[ord[k]].arrival <= t){ q_push(&q, ord[k]); inq[ord[k]]=1; k++; }
 
     int cur_pid=-2; int seg_start=t;
 
     while (completed < n){
+        if (t >= lim_t || st.events >= lim_ev) break;
         if (q_empty(&q)){
             if (k<n){
-                if (cur_pid!=-1){ if (cur_pid!=-2) seg_push(&sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t}); cur_pid=-1; seg_start=t; }
-                seg_push(&sv,(Seg){.pid=-1,.start=t,.end=pr[ord[k]].arrival});
-                t = pr[ord[k]].arrival;
+                int to = pr[ord[k]].arrival < lim_t ? pr[ord[k]].arrival : lim_t;
+                if (cur_pid!=-1){ if (cur_pid!=-2) seg_push(sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t}); cur_pid=-1; seg_start=t; }
+                seg_push(sv,(Seg){.pid=-1,.start=t,.end=to});
+                st.idle += to - t;
+                t = to;
                 cur_pid=-2; seg_start=t;
-                while (k<n && pr[ord[k]].arrival <= t){ q_push(&q, ord[k]); inq[ord[k]]=1; k++; }
+                while (k<n && pr[ord[k]].arrival <= t){ q_push(&q, ord[k]); inq[ord[k]]=1; k++; st.events++; }
                 continue;
             } else break;
         }
 
         int i = q_pop(&q); inq[i]=0;
+        if (start[i]==-1 && cfg->reneging && job_abandons(cfg, pr, i, t)){
+            end[i] = JOB_ABANDONED; rem[i] = 0; completed++;
+            if (au) audit_emit(au, AUD_ABANDON, ALG_RR, pr[i].arrival + job_patience(cfg, i), pr[i].pid, -1, job_patience(cfg, i), 0, 0);
+            continue;
+        }
         if (start[i]==-1) start[i]=t;
+        if (au){
+            int r = q.size ? q.q[q.front] : -1;
+            audit_emit(au, AUD_DISPATCH, ALG_RR, t, pr[i].pid, r<0 ? -1 : pr[r].pid, rem[i], r<0 ? 0 : rem[r], q.size+1);
+        }
 
         if (cur_pid != pr[i].pid){
-            if (cur_pid!=-2) seg_push(&sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t});
+            if (cur_pid!=-2) seg_push(sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t});
             cur_pid = pr[i].pid; seg_start=t;
         }
 
         int slice = rem[i] < quantum ? rem[i] : quantum;
-        int old_t = t; t += slice; rem[i] -= slice;
+        if (slice > lim_t - t) slice = lim_t - t;
+        t += slice; rem[i] -= slice;
+        st.dispatches++;
 
-        while (k<n && pr[ord[k]].arrival <= t){ if(!inq[ord[k]]){ q_push(&q, ord[k]); inq[ord[k]]=1; } k++; }
+        while (k<n && pr[ord[k]].arrival <= t){ if(!inq[ord[k]]){ q_push(&q, ord[k]); inq[ord[k]]=1; } k++; st.events++; }
 
-        if (rem[i]==0){ end[i]=t; completed++; }
-        else { q_push(&q, i); inq[i]=1; }
+        if (rem[i]==0){
+            end[i]=t; completed++; st.completions++;
+            if (au) audit_emit(au, AUD_COMPLETE, ALG_RR, t, pr[i].pid, -1, pr[i].burst, 0, 0);
+        } else {
+            if (!q_empty(&q)){
+                st.preemptions++;
+                if (au){ int r = q.q[q.front]; audit_emit(au, AUD_PREEMPT, ALG_RR, t, pr[i].pid, pr[r].pid, rem[i], rem[r], q.size+1); }
+            }
+            q_push(&q, i); inq[i]=1;
+        }
+        st.qdepth = q.size; if (q.size > st.qdepth_max) st.qdepth_max = q.size;
+        if (++st.events >= mb.next) met_flush(&mb, &st);
     }
-    if (cur_pid!=-2) seg_push(&sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t});
-    seg_coalesce(&sv);
+    if (cur_pid!=-2) seg_push(sv,(Seg){.pid=cur_pid,.start=seg_start,.end=t});
+    o->stop = t; o->truncated = completed < n;
+    met_end(&mb, &st, pr, n, start, end);
+    seg_coalesce(sv);
+    q_free(&q); free(ord); free(inq);
+    if (rem != o->left) free(rem);
+}
 
-    printf("Round Robin Scheduling (q=%d) =>\n", quantum);
-    print_gantt(ALG, &sv, cfg);
-    print_pertick(ALG, &sv, cfg);
-    print_avgs(ALG, pr, n, start, end);
-    csv_dump_algo(csv, ALG, pr, n, start, end);
+/* Shared tail of the run_* wrappers. */
+static void report_run(const char *alg, const Proc *pr, int n, const SimOut *o, Csv *csv, const Config *cfg){
+    print_gantt(alg, o->sv, cfg);
+    print_pertick(alg, o->sv, cfg);
+    print_avgs(alg, pr, n, o->start, o->end);
+    if (cfg->reneging){
+        long long gone = 0, done = 0, work = 0;
+        for (int i=0;i<n;i++){
+            if (job_gone(cfg, pr, o, i)) gone++;
+            else if (o->end[i] >= 0){ done++; work += pr[i].burst; }
+        }
+        printf("  Abandoned: %lld of %d (%.2f%%); goodput %lld jobs / %lld work units in %d time (%.4f jobs per unit)\n\n",
+               gone, n, 100.0 * gone / n, done, work, o->stop, o->stop ? (double)done / o->stop : 0.0);
+    }
+    if (o->truncated) print_partial(pr, n, o, cfg);
+    csv_dump_algo(csv, alg, pr, n, o->start, o->end);
+    if (cfg->seg_prefix[0] && o->sv) seg_save(cfg->seg_prefix, alg, o->sv);
+}
 
-    seg_free(&sv); q_free(&q); free(ord); free(start); free(end); free(rem); free(inq);
+/* run_* buffers; `left` is only needed to report truncated runs */
+static SimOut run_alloc(int n, const Config *cfg, SegVec *sv){
+    bool limited = cfg->until != INT_MAX || cfg->max_events != LLONG_MAX;
+    int *start=(int*)malloc(n*sizeof(int)), *end=(int*)malloc(n*sizeof(int));
+    int *left = limited ? (int*)malloc(n*sizeof(int)) : NULL;
+    if(!start||!end||(limited && !left)){fprintf(stderr,"OOM\n");exit(1);}
+    SimOut o; simout_init(&o, start, end, left, sv);
+    return o;
 }
+static void run_free(SimOut *o){ seg_free(o->sv); free(o->start); free(o->end); free(o->left); }
 
-/* ===================== Main ===================== */
+static void run_fcfs(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    const char *ALG = "FCFS";
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    sim_fcfs(pr, n, cfg, &o);
 
-int main(int argc, char **argv){
-    Config cfg; config_default(&cfg); parse_args(&cfg, argc, argv);
+    printf("\nFCFS (FIFO) Scheduling =>\n");
+    report_run(ALG, pr, n, &o, csv, cfg);
+    run_free(&o);
+}
 
-    printf("Number of Processes: ");
-    int n = read_int("number of processes");
-    if (n <= 0){ fprintf(stderr,"ERROR: n must be positive\n"); return 1; }
+static void run_sjf(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    const char *ALG = "SJF";
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    sim_sjf(pr, n, cfg, &o);
+
+    printf("SJF (Non-preemptive) Scheduling =>\n");
+    report_run(ALG, pr, n, &o, csv, cfg);
+    run_free(&o);
+}
 
-    Proc *pr = (Proc*)malloc(n*sizeof(Proc));
-    if (!pr){ fprintf(stderr,"OOM\n"); return 1; }
+static void run_srtf(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    const char *ALG = "SRTF";
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    sim_srtf(pr, n, cfg, &o);
 
-    printf("Enter details for each process on its own line: PID Arrival Burst\n");
-    for (int i=0;i<n;i++){
-        int pid = read_int("PID");
-        int arr = read_int("Arrival");
-        int bur = read_int("Burst");
-        if (arr < 0 || bur <= 0){ fprintf(stderr,"ERROR: Arrival >= 0, Burst > 0\n"); free(pr); return 1; }
-        pr[i].pid=pid; pr[i].arrival=arr; pr[i].burst=bur;
+    printf("SRTF (Preemptive SJF) Scheduling =>\n");
+    report_run(ALG, pr, n, &o, csv, cfg);
+    run_free(&o);
+}
+
+static void run_rr(const Proc *pr, int n, int quantum, Csv *csv, const Config *cfg){
+    char ALG[64]; snprintf(ALG,sizeof(ALG),"RoundRobin(q=%d)",quantum);
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    sim_rr(pr, n, quantum, cfg, &o);
+
+    printf("Round Robin Scheduling (q=%d) =>\n", quantum);
+    report_run(ALG, pr, n, &o, csv, cfg);
+    run_free(&o);
+}
+
+/* ===================== Streaming engines ===================== */
+/* Steppers run one policy incrementally: jobs are handed over in arrival
+   order and only the ready structure and the running job are kept, so
+   memory is bounded by the queue depth. The driver calls stp_advance(s, a)
+   before feeding the jobs that arrive at time a; events at exactly a are left
+   for later, so decisions at a see every arrival at a. This matches the
+   batch engines, including their tie-breaks. */
+
+typedef struct { int pid, arrival, burst, rem, start; long long row; } SJob;
+
+typedef struct Stepper {
+    int alg, quantum;
+    int t; bool started;
+    SJob *a; int sz, cap, head;       /* heap (FCFS/SJF/SRTF) or ring (RR) */
+    SJob run; bool busy; int slice_end;
+    bool fresh;                       /* SRTF: arrivals since the last decision */
+    SegVec *sv; int cur, seg_start;   /* optional timeline */
+    void (*done)(void *ctx, const SJob *j, int end); void *ctx;
+    long long completed; int qdepth_max;
+} Stepper;
+
+static void stp_init(Stepper *s, int alg, int quantum, SegVec *sv, void (*done)(void*, const SJob*, int), void *ctx){
+    memset(s, 0, sizeof(*s));
+    s->alg = alg; s->quantum = quantum; s->sv = sv; s->cur = -2;
+    s->done = done; s->ctx = ctx;
+}
+static void stp_free(Stepper *s){ free(s->a); s->a = NULL; }
+
+static bool stp_less(int alg, const SJob *x, const SJob *y){
+    if (alg == ALG_SJF  && x->burst != y->burst) return x->burst < y->burst;
+    if (alg == ALG_SRTF && x->rem   != y->rem)   return x->rem   < y->rem;
+    if (x->arrival != y->arrival) return x->arrival < y->arrival;
+    return x->pid < y->pid;
+}
+static void stp_grow(Stepper *s){
+    int nc = s->cap ? s->cap*2 : 64;
+    SJob *na = (SJob*)malloc(nc*sizeof(SJob));
+    if (!na){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<s->sz;i++) na[i] = s->a[s->alg == ALG_RR ? (s->head+i) % s->cap : i];
+    free(s->a); s->a = na; s->cap = nc; s->head = 0;
+}
+static void stp_push(Stepper *s, SJob j){
+    if (s->sz == s->cap) stp_grow(s);
+    if (s->alg == ALG_RR){ s->a[(s->head + s->sz++) % s->cap] = j; }
+    else {
+        int i = s->sz++;
+        while (i > 0 && stp_less(s->alg, &j, &s->a[(i-1)/2])){ s->a[i] = s->a[(i-1)/2]; i = (i-1)/2; }
+        s->a[i] = j;
     }
+    if (s->sz > s->qdepth_max) s->qdepth_max = s->sz;
+}
+static SJob stp_pop(Stepper *s){
+    SJob top;
+    if (s->alg == ALG_RR){ top = s->a[s->head]; s->head = (s->head+1) % s->cap; s->sz--; return top; }
+    top = s->a[0];
+    SJob v = s->a[--s->sz]; int i = 0;
+    for (;;){
+        int l = 2*i+1, m = l;
+        if (l >= s->sz) break;
+        if (l+1 < s->sz && stp_less(s->alg, &s->a[l+1], &s->a[l])) m = l+1;
+        if (!stp_less(s->alg, &s->a[m], &v)) break;
+        s->a[i] = s->a[m]; i = m;
+    }
+    if (s->sz) s->a[i] = v;
+    return top;
+}
+static void stp_seg(Stepper *s, int pid){
+    if (s->cur == pid) return;
+    if (s->cur != -2 && s->seg_start < s->t) seg_push(s->sv, (Seg){.pid=s->cur,.start=s->seg_start,.end=s->t});
+    s->cur = pid; s->seg_start = s->t;
+}
 
-    Csv csv; csv_open(&csv, &cfg);
+/* Hand over a job; arrivals must come in (arrival, pid) order. */
+static void stp_arrive(Stepper *s, SJob j){
+    j.rem = j.burst; j.start = -1;
+    if (!s->started){ s->t = j.arrival; s->seg_start = j.arrival; s->started = true; }
+    else if (!s->busy && s->sz == 0 && s->t < j.arrival){ stp_seg(s, -1); s->t = j.arrival; }
+    stp_push(s, j);
+    s->fresh = true;
+}
+
+/* Process every event strictly before `until`. */
+static void stp_advance(Stepper *s, int until){
+    for (;;){
+        if (s->t >= until) return;
+        if (s->busy && s->fresh && s->alg == ALG_SRTF && s->sz && stp_less(ALG_SRTF, &s->a[0], &s->run)){
+            stp_push(s, s->run); s->busy = false;
+        }
+        s->fresh = false;
+        if (!s->busy){
+            if (!s->sz) return;
+            s->run = stp_pop(s); s->busy = true;
+            if (s->run.start < 0) s->run.start = s->t;
+            s->slice_end = s->t + (s->run.rem < s->quantum ? s->run.rem : s->quantum);
+            stp_seg(s, s->run.pid);
+        }
+        int e = s->alg == ALG_RR ? s->slice_end : s->t + s->run.rem;
+        if (e >= until){ s->run.rem -= until - s->t; s->t = until; return; }
+        s->run.rem -= e - s->t; s->t = e;
+        s->busy = false;
+        if (s->run.rem == 0){ s->completed++; if (s->done) s->done(s->ctx, &s->run, s->t); }
+        else stp_push(s, s->run);              /* RR slice expired */
+    }
+}
+/* Time of the next event the stepper would process, INT_MAX when empty. */
+static int stp_next_event(const Stepper *s){
+    if (s->busy) return s->alg == ALG_RR ? s->slice_end : s->t + s->run.rem;
+    return s->sz ? s->t : INT_MAX;
+}
+static void stp_drain(Stepper *s){
+    stp_advance(s, INT_MAX);
+    stp_seg(s, -2);
+    seg_coalesce(s->sv);
+}
 
-    if (cfg.run_fcfs) run_fcfs(pr, n, &csv, &cfg);
-    if (cfg.run_sjf)  run_sjf (pr, n, &csv, &cfg);
-    if (cfg.run_srtf) run_srtf(pr, n, &csv, &cfg);
-    if (cfg.run_rr)   run_rr  (pr, n, cfg.quantum, &csv, &cfg);
+/* ===================== Pipelined input ===================== */
+/* --pipeline / --lockstep: a parser thread turns stdin into fixed-size Proc blocks and
+   hands them to the engine thread through a single-producer/single-consumer
+   ring; the engine starts simulating with the first block, so wall time
+   approaches max(parse, simulate). Input must be in arrival order; equal
+   arrivals are regrouped by PID before they are fed. */
 
-    if (csv.open){ csv_close(&csv); printf("CSV written: %s\n", cfg.csv_path); }
-    free(pr);
-    return 0;
+#define PIPE_BLOCK 4096
+#define PIPE_SLOTS 64
+
+typedef struct { Proc p[PIPE_BLOCK]; int len; } ProcBlock;
+
+typedef struct {
+    ProcBlock *slot;
+    _Atomic unsigned head, tail;      /* producer owns head, consumer owns tail */
+    _Atomic bool eof;
+    FILE *in;
+    int n;                            /* job count from the header */
+    double parse_secs;
+    pthread_t th;
+} Pipe;
+
+typedef struct { FILE *in; char *buf; size_t pos, len; } FastIn;
+
+static bool fast_int(FastIn *f, int *out){
+    int c;
+    for (;;){
+        if (f->pos == f->len){ f->len = fread(f->buf, 1, 1<<20, f->in); f->pos = 0; if (!f->len) return false; }
+        c = (unsigned char)f->buf[f->pos];
+        if (c != ' ' && c != '\n' && c != '\t' && c != '\r') break;
+        f->pos++;
+    }
+    bool neg = c == '-'; if (neg) f->pos++;
+    long long v = 0; int digits = 0;
+    for (;;){
+        if (f->pos == f->len){ f->len = fread(f->buf, 1, 1<<20, f->in); f->pos = 0; if (!f->len) break; }
+        c = (unsigned char)f->buf[f->pos];
+        if (c < '0' || c > '9') break;
+        v = v*10 + (c - '0'); digits++; f->pos++;
+        if (v > INT_MAX){ fprintf(stderr,"ERROR: integer out of range\n"); exit(1); }
+    }
+    if (!digits){ fprintf(stderr,"ERROR: expected an integer in the input\n"); exit(1); }
+    *out = neg ? (int)-v : (int)v;
+    return true;
+}
+
+static void *pipe_parser(void *arg){
+    Pipe *pp = (Pipe*)arg;
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+    FastIn f = { pp->in, (char*)malloc(1<<20), 0, 0 };
+    if (!f.buf){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0; i<pp->n; ){
+        unsigned h = atomic_load_explicit(&pp->head, memory_order_relaxed);
+        while (h - atomic_load_explicit(&pp->tail, memory_order_acquire) == PIPE_SLOTS) sched_yield();
+        ProcBlock *b = &pp->slot[h % PIPE_SLOTS];
+        b->len = 0;
+        for (; i<pp->n && b->len<PIPE_BLOCK; i++){
+            Proc *p = &b->p[b->len++];
+            if (!fast_int(&f, &p->pid) || !fast_int(&f, &p->arrival) || !fast_int(&f, &p->burst)){
+                fprintf(stderr,"ERROR: Failed to read process %d\n", i+1); exit(1);
+            }
+            if (p->arrival < 0 || p->burst <= 0){ fprintf(stderr,"ERROR: Arrival >= 0, Burst > 0\n"); exit(1); }
+        }
+        atomic_store_explicit(&pp->head, h+1, memory_order_release);
+    }
+    free(f.buf);
+    clock_gettime(CLOCK_MONOTONIC, &t1); pp->parse_secs = ts_diff(&t0, &t1);
+    atomic_store_explicit(&pp->eof, true, memory_order_release);
+    return NULL;
+}
+
+static void pipe_start(Pipe *pp, FILE *in, int n){
+    pp->slot = (ProcBlock*)malloc(PIPE_SLOTS*sizeof(ProcBlock));
+    if (!pp->slot){ fprintf(stderr,"OOM\n"); exit(1); }
+    atomic_init(&pp->head, 0); atomic_init(&pp->tail, 0); atomic_init(&pp->eof, false);
+    pp->in = in; pp->n = n; pp->parse_secs = 0;
+    if (pthread_create(&pp->th, NULL, pipe_parser, pp)){ fprintf(stderr,"ERROR: cannot start parser thread\n"); exit(1); }
 }
+/* Next filled block, or NULL once the parser is done and the ring is empty. */
+static const ProcBlock *pipe_next(Pipe *pp){
+    unsigned t = atomic_load_explicit(&pp->tail, memory_order_relaxed);
+    for (;;){
+        if (atomic_load_explicit(&pp->head, memory_order_acquire) != t) return &pp->slot[t % PIPE_SLOTS];
+        if (atomic_load_explicit(&pp->eof, memory_order_acquire) && atomic_load_explicit(&pp->head, memory_order_acquire) == t) return NULL;
+        sched_yield();
+    }
+}
+static void pipe_release(Pipe *pp){ atomic_fetch_add_explicit(&pp->tail, 1, memory_order_release); }
+static void pipe_join(Pipe *pp){ pthread_join(pp->th, NULL); free(pp->slot); }
 
+/* Feeds a stream to the steppers, one arrival instant at a time. */
+typedef struct { SJob *g; int len, cap; int at; } ArrivalGroup;
+
+static int cmp_sjob_pid(const void *a, const void *b){
+    int x = ((const SJob*)a)->pid, y = ((const SJob*)b)->pid;
+    return (x > y) - (x < y);
+}
+static void group_flush(ArrivalGroup *g, Stepper *s, int ns){
+    if (!g->len) return;
+    if (g->len > 1) qsort(g->g, g->len, sizeof(SJob), cmp_sjob_pid);
+    for (int k=0;k<ns;k++){
+        stp_advance(&s[k], g->at);
+        for (int i=0;i<g->len;i++) stp_arrive(&s[k], g->g[i]);
+    }
+    g->len = 0;
+}
+static void group_add(ArrivalGroup *g, Stepper *s, int ns, const Proc *p, long long row){
+    if (g->len && p->arrival != g->at){
+        if (p->arrival < g->at){ fprintf(stderr,"ERROR: streamed input must be sorted by arrival (P%d arrives at %d after t=%d)\n", p->pid, p->arrival, g->at); exit(1); }
+        group_flush(g, s, ns);
+    }
+    if (g->len == g->cap){ g->cap = g->cap ? g->cap*2 : 64; g->g = (SJob*)realloc(g->g, g->cap*sizeof(SJob)); if (!g->g){ fprintf(stderr,"OOM\n"); exit(1); } }
+    g->at = p->arrival;
+    g->g[g->len++] = (SJob){ .pid=p->pid, .arrival=p->arrival, .burst=p->burst, .row=row };
+}
+
+/* per-policy result sums; completions stream straight into the CSV */
+typedef struct { char alg[64]; Csv *csv; OutBuf *norm; double sr, sw, st; long long done; } StreamAcc;
+
+static void stream_done(void *ctx, const SJob *j, int end){
+    StreamAcc *a = (StreamAcc*)ctx;
+    int resp = j->start - j->arrival, tat = end - j->arrival, wait = tat - j->burst;
+    a->sr += resp; a->sw += wait; a->st += tat; a->done++;
+    if (a->norm) norm_row(a->csv->norm, a->norm, j->row, j->arrival, j->burst, j->start, end);
+    if (a->csv && a->csv->path)
+        fprintf(csv_file(a->csv), "%s,%d,%d,%d,%d,%d,%d,%d,%d\n", a->alg, j->pid, j->arrival, j->burst, j->start, end, resp, wait, tat);
+}
+
+/* --pipeline / --lockstep: every selected algorithm advances over the one
+   parsed stream; memory is the ring plus each policy's ready queue (and the
+   timelines when --gantt or --per-tick asks for them). */
+static void stream_run(int n, Csv *csv, const Config *cfg){
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+    int algs[4], ns = 0;
+    if (cfg->run_fcfs) algs[ns++] = ALG_FCFS;
+    if (cfg->run_sjf)  algs[ns++] = ALG_SJF;
+    if (cfg->run_srtf) algs[ns++] = ALG_SRTF;
+    if (cfg->run_rr)   algs[ns++] = ALG_RR;
+    bool timeline = cfg->print_gantt || cfg->print_pertick;
+    Stepper s[4]; StreamAcc acc[4]; SegVec sv[4];
+    for (int k=0;k<ns;k++){
+        static const char *NAMES[] = {"FCFS","SJF","SRTF"};
+        if (algs[k] == ALG_RR) snprintf(acc[k].alg, sizeof(acc[k].alg), "RoundRobin(q=%d)", cfg->quantum);
+        else snprintf(acc[k].alg, sizeof(acc[k].alg), "%s", NAMES[algs[k]]);
+        acc[k].csv = csv; acc[k].norm = csv->norm ? norm_file(csv->norm, acc[k].alg) : NULL; acc[k].sr = acc[k].sw = acc[k].st = 0; acc[k].done = 0;
+        memset(&sv[k], 0, sizeof(SegVec));
+        stp_init(&s[k], algs[k], cfg->quantum, timeline ? &sv[k] : NULL, stream_done, &acc[k]);
+    }
+    ArrivalGroup g = {0};
+    Pipe pp; pipe_start(&pp, stdin, n);
+    long long fed = 0;
+    for (const ProcBlock *b; (b = pipe_next(&pp)); pipe_release(&pp)){
+        long long row = (csv->norm ? csv->norm->row_base : 0) + fed;
+        if (csv->norm) norm_workload(csv->norm, row, b->p, b->len);
+        for (int i=0;i<b->len;i++) group_add(&g, s, ns, &b->p[i], row + i);
+        fed += b->len;
+    }
+    group_flush(&g, s, ns);
+    for (int k=0;k<ns;k++) stp_drain(&s[k]);
+    pipe_join(&pp);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    for (int k=0;k<ns;k++){
+        printf("\n%s Scheduling (%s) =>\n", acc[k].alg, ns > 1 ? "lockstep" : "pipelined");
+        print_gantt(acc[k].alg, &sv[k], cfg);
+        print_pertick(acc[k].alg, &sv[k], cfg);
+        print_avg_sums(acc[k].alg, acc[k].sr, acc[k].sw, acc[k].st, acc[k].done);
+        printf("  Max ready queue: %d\n", s[k].qdepth_max);
+        seg_free(&sv[k]); stp_free(&s[k]);
+    }
+    printf("\nStreamed %lld jobs through %d polic%s in one pass: parse %.3fs, total %.3fs\n\n",
+           fed, ns, ns == 1 ? "y" : "ies", pp.parse_secs, ts_diff(&t0, &t1));
+    if (csv->norm) csv->norm->row_base += fed;
+    free(g.g);
+}
+
+/* ===================== Shared-resource contention ===================== */
+/* --locks=FILE lists critical sections, one per line: PID RESOURCE OFFSET LENGTH
+   (OFFSET counted in the job's own execution time). Sections of one job must
+   not overlap, so a holder never blocks and inheritance chains have length 1.
+   Only the preemptive engines can block on a held lock on one CPU: SRTF
+   (priority = remaining time) with --lock-protocol=none|inherit|ceiling, and
+   RR with FIFO wait queues. Ceilings use the shortest burst among a
+   resource's users. */
+
+typedef struct { int *at, *len, *res; int *off; int total; } CritSecs;   /* CSR by job */
+typedef struct {
+    int holder;
+    int *w; int wsz, wcap;                     /* waiters, heap on (wkey, seq) */
+    long long ceil;
+    long long acquisitions, contended, wait;
+} Resource;
+typedef struct {
+    char **names; int len, cap;
+    int *slots; int nslots;                    /* open addressing, -1 = empty */
+    Resource *r;
+    CritSecs cs;
+} LockSet;
+
+static uint64_t str_hash(const char *s){ uint64_t h = 1469598103934665603ULL; while (*s){ h ^= (unsigned char)*s++; h *= 1099511628211ULL; } return h; }
+
+static int lock_intern(LockSet *ls, const char *name){
+    if (ls->len*2 >= ls->nslots){
+        int ns = ls->nslots ? ls->nslots*2 : 1024;
+        int *sl = (int*)malloc(ns*sizeof(int));
+        if (!sl){ fprintf(stderr,"OOM\n"); exit(1); }
+        for (int i=0;i<ns;i++) sl[i] = -1;
+        for (int id=0; id<ls->len; id++){
+            uint64_t h = str_hash(ls->names[id]) & (ns-1);
+            while (sl[h] >= 0) h = (h+1) & (ns-1);
+            sl[h] = id;
+        }
+        free(ls->slots); ls->slots = sl; ls->nslots = ns;
+    }
+    uint64_t h = str_hash(name) & (ls->nslots-1);
+    while (ls->slots[h] >= 0){
+        if (!strcmp(ls->names[ls->slots[h]], name)) return ls->slots[h];
+        h = (h+1) & (ls->nslots-1);
+    }
+    if (ls->len == ls->cap){
+        ls->cap = ls->cap ? ls->cap*2 : 256;
+        ls->names = (char**)realloc(ls->names, ls->cap*sizeof(char*));
+        if (!ls->names){ fprintf(stderr,"OOM\n"); exit(1); }
+    }
+    ls->names[ls->len] = strdup(name);
+    ls->slots[h] = ls->len;
+    return ls->len++;
+}
+
+/* Row index for a PID via binary search over a pid-sorted index. */
+static _Thread_local const Proc *g_pid_sort = NULL;
+static int cmp_pid_index(const void *a, const void *b){
+    int x = g_pid_sort[*(const int*)a].pid, y = g_pid_sort[*(const int*)b].pid;
+    return (x > y) - (x < y);
+}
+static int *pid_index(const Proc *pr, int n){
+    int *ix = (int*)malloc((n ? n : 1)*sizeof(int));
+    if (!ix){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++) ix[i] = i;
+    g_pid_sort = pr; qsort(ix, n, sizeof(int), cmp_pid_index);
+    for (int i=1;i<n;i++) if (pr[ix[i]].pid == pr[ix[i-1]].pid){ fprintf(stderr,"ERROR: duplicate PID %d\n", pr[ix[i]].pid); exit(1); }
+    return ix;
+}
+static int pid_lookup(const Proc *pr, const int *ix, int n, int pid){
+    int lo = 0, hi = n-1;
+    while (lo <= hi){ int m = (lo+hi)/2, v = pr[ix[m]].pid; if (v == pid) return ix[m]; if (v < pid) lo = m+1; else hi = m-1; }
+    return -1;
+}
+
+typedef struct { int job, at, len, res; } CsLine;
+static int cmp_csline(const void *a, const void *b){
+    const CsLine *x = (const CsLine*)a, *y = (const CsLine*)b;
+    if (x->job != y->job) return x->job < y->job ? -1 : 1;
+    return (x->at > y->at) - (x->at < y->at);
+}
+
+static void locks_load(LockSet *ls, const char *path, const Proc *pr, int n){
+    memset(ls, 0, sizeof(*ls));
+    FILE *f = fopen(path, "r");
+    if (!f){ fprintf(stderr,"ERROR: cannot open %s\n", path); exit(1); }
+    int *ix = pid_index(pr, n);
+    CsLine *v = NULL; int len = 0, cap = 0;
+    int pid, at, l; char name[128];
+    while (fscanf(f, "%d %127s %d %d", &pid, name, &at, &l) == 4){
+        int j = pid_lookup(pr, ix, n, pid);
+        if (j < 0){ fprintf(stderr,"ERROR: %s: unknown PID %d\n", path, pid); exit(1); }
+        if (at < 0 || l <= 0 || at + l > pr[j].burst){ fprintf(stderr,"ERROR: %s: section of P%d outside its burst\n", path, pid); exit(1); }
+        if (len == cap){ cap = cap ? cap*2 : 1024; v = (CsLine*)realloc(v, cap*sizeof(CsLine)); if (!v){ fprintf(stderr,"OOM\n"); exit(1); } }
+        v[len++] = (CsLine){ j, at, l, lock_intern(ls, name) };
+    }
+    if (!feof(f)){ fprintf(stderr,"ERROR: %s: expected PID RESOURCE OFFSET LENGTH\n", path); exit(1); }
+    fclose(f); free(ix);
+    qsort(v, len, sizeof(CsLine), cmp_csline);
+    CritSecs *cs = &ls->cs;
+    cs->total = len;
+    cs->at = (int*)malloc((len ? len : 1)*sizeof(int)); cs->len = (int*)malloc((len ? len : 1)*sizeof(int));
+    cs->res = (int*)malloc((len ? len : 1)*sizeof(int)); cs->off = (int*)calloc(n+1, sizeof(int));
+    ls->r = (Resource*)calloc(ls->len ? ls->len : 1, sizeof(Resource));
+    if (!cs->at||!cs->len||!cs->res||!cs->off||!ls->r){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int r=0;r<ls->len;r++) ls->r[r].ceil = LLONG_MAX;
+    for (int e=0;e<len;e++){
+        if (e && v[e].job == v[e-1].job && v[e].at < v[e-1].at + v[e-1].len){
+            fprintf(stderr,"ERROR: %s: overlapping sections for P%d (nesting is not supported)\n", path, pr[v[e].job].pid); exit(1);
+        }
+        cs->at[e] = v[e].at; cs->len[e] = v[e].len; cs->res[e] = v[e].res;
+        cs->off[v[e].job+1]++;
+        if (pr[v[e].job].burst < ls->r[v[e].res].ceil) ls->r[v[e].res].ceil = pr[v[e].job].burst;
+    }
+    for (int j=0;j<n;j++) cs->off[j+1] += cs->off[j];
+    free(v);
+}
+static void locks_free(LockSet *ls){
+    for (int i=0;i<ls->len;i++){ free(ls->names[i]); free(ls->r[i].w); }
+    free(ls->names); free(ls->slots); free(ls->r);
+    free(ls->cs.at); free(ls->cs.len); free(ls->cs.res); free(ls->cs.off);
+}
+
+/* Indexed min-heap over job indices on (key[i], arrival, pid), with
+   decrease-key and removal; pos[i] = -1 when i is not in the heap. */
+typedef struct { int *h, *pos; int sz; const long long *key; const Proc *pr; } IHeap;
+
+static void ih_init(IHeap *q, int n, const long long *key, const Proc *pr){
+    q->h = (int*)malloc((n ? n : 1)*sizeof(int)); q->pos = (int*)malloc((n ? n : 1)*sizeof(int));
+    if (!q->h || !q->pos){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++) q->pos[i] = -1;
+    q->sz = 0; q->key = key; q->pr = pr;
+}
+static void ih_free(IHeap *q){ free(q->h); free(q->pos); }
+static bool ih_less(const IHeap *q, int a, int b){
+    if (q->key[a] != q->key[b]) return q->key[a] < q->key[b];
+    if (q->pr[a].arrival != q->pr[b].arrival) return q->pr[a].arrival < q->pr[b].arrival;
+    return q->pr[a].pid < q->pr[b].pid;
+}
+static void ih_set(IHeap *q, int at, int v){ q->h[at] = v; q->pos[v] = at; }
+static void ih_up(IHeap *q, int i){
+    int v = q->h[i];
+    while (i > 0){ int p = (i-1)/2; if (!ih_less(q, v, q->h[p])) break; ih_set(q, i, q->h[p]); i = p; }
+    ih_set(q, i, v);
+}
+static void ih_down(IHeap *q, int i){
+    int v = q->h[i];
+    for (;;){
+        int l = 2*i+1, r = l+1, m = l;
+        if (l >= q->sz) break;
+        if (r < q->sz && ih_less(q, q->h[r], q->h[l])) m = r;
+        if (!ih_less(q, q->h[m], v)) break;
+        ih_set(q, i, q->h[m]); i = m;
+    }
+    ih_set(q, i, v);
+}
+static void ih_push(IHeap *q, int v){ q->h[q->sz] = v; q->pos[v] = q->sz; q->sz++; ih_up(q, q->sz-1); }
+static void ih_remove(IHeap *q, int v){
+    int i = q->pos[v]; if (i < 0) return;
+    q->pos[v] = -1; q->sz--;
+    if (i == q->sz) return;
+    int m = q->h[q->sz];
+    ih_set(q, i, m); ih_up(q, i); ih_down(q, q->pos[m]);
+}
+static int ih_pop(IHeap *q){ int v = q->h[0]; ih_remove(q, v); return v; }
+static void ih_decrease(IHeap *q, int v){ if (q->pos[v] >= 0) ih_up(q, q->pos[v]); }
+
+/* per-resource waiter heap on (wkey, job) */
+static bool w_less(const long long *wkey, int a, int b){ return wkey[a] != wkey[b] ? wkey[a] < wkey[b] : a < b; }
+static void w_push(Resource *r, const long long *wkey, int j){
+    if (r->wsz == r->wcap){ r->wcap = r->wcap ? r->wcap*2 : 4; r->w = (int*)realloc(r->w, r->wcap*sizeof(int)); if (!r->w){ fprintf(stderr,"OOM\n"); exit(1); } }
+    int i = r->wsz++;
+    while (i > 0 && w_less(wkey, j, r->w[(i-1)/2])){ r->w[i] = r->w[(i-1)/2]; i = (i-1)/2; }
+    r->w[i] = j;
+}
+static int w_pop(Resource *r, const long long *wkey){
+    int top = r->w[0], v = r->w[--r->wsz], i = 0;
+    for (;;){
+        int l = 2*i+1, m = l;
+        if (l >= r->wsz) break;
+        if (l+1 < r->wsz && w_less(wkey, r->w[l+1], r->w[l])) m = l+1;
+        if (!w_less(wkey, r->w[m], v)) break;
+        r->w[i] = r->w[m]; i = m;
+    }
+    if (r->wsz) r->w[i] = v;
+    return top;
+}
+
+/* SRTF key of a job: its remaining time, lowered while it holds a resource
+   by the best waiter (inherit) or by the resource ceiling. */
+static long long lock_eff(const LockSet *ls, int protocol, const long long *wkey, int rem, int held){
+    long long e = rem;
+    if (held < 0) return e;
+    const Resource *r = &ls->r[held];
+    if (protocol == LP_INHERIT && r->wsz && wkey[r->w[0]] < e) e = wkey[r->w[0]];
+    if (protocol == LP_CEILING && r->ceil < e) e = r->ceil;
+    return e;
+}
+
+typedef struct {
+    long long acquisitions, contended, blocked, inversion, inversion_unbounded;
+    long long blocked_max;
+} LockStats;
+
+/* SRTF or RR with critical sections. The running job is kept outside the
+   ready heap; events are arrivals, completions, section entry/exit and (RR)
+   quantum expiry. */
+static void sim_locks(const Proc *pr, int n, int alg, int quantum, int protocol, LockSet *ls, const Config *cfg, SimOut *o, LockStats *ls_out){
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const CritSecs *cs = &ls->cs;
+    int *rem = (int*)malloc(n*sizeof(int)), *csn = (int*)malloc(n*sizeof(int)), *hold = (int*)malloc(n*sizeof(int));
+    long long *ekey = (long long*)malloc(n*sizeof(long long)), *wkey = (long long*)malloc(n*sizeof(long long));
+    long long *blocked_since = (long long*)malloc(n*sizeof(long long)), *blocked = (long long*)calloc(n, sizeof(long long));
+    if (!rem||!csn||!hold||!ekey||!wkey||!blocked_since||!blocked){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){ start[i]=-1; end[i]=-1; rem[i]=pr[i].burst; csn[i]=cs->off[i]; hold[i]=-1; }
+    for (int r=0;r<ls->len;r++){ ls->r[r].holder = -1; ls->r[r].wsz = 0; ls->r[r].acquisitions = ls->r[r].contended = ls->r[r].wait = 0; }
+    int *ord = arrival_order(pr, n);
+    IHeap ready; ih_init(&ready, n, ekey, pr);
+    IHeap blk;   ih_init(&blk, n, wkey, pr);      /* blocked jobs by base key, for inversion time */
+    LockStats L = {0};
+    long long seq = 0;
+    bool srtf = alg == ALG_SRTF;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events; long long events = 0;
+    #define EFF(i) lock_eff(ls, protocol, wkey, rem[i], hold[i])
+    #define MAKE_READY(i) do { ekey[i] = srtf ? EFF(i) : seq++; ih_push(&ready, i); } while (0)
+
+    long long t = n ? pr[ord[0]].arrival : 0, slice_end = 0;
+    int k = 0, completed = 0, run = -1, cur = -2; long long seg_start = t;
+
+    while (completed < n){
+        if (t >= lim_t || events >= lim_ev) break;
+        events++;
+        while (k<n && pr[ord[k]].arrival <= t){ MAKE_READY(ord[k]); k++; }
+        if (run >= 0 && srtf && ready.sz){
+            ekey[run] = EFF(run);
+            if (ih_less(&ready, ready.h[0], run)){ MAKE_READY(run); run = -1; }
+        }
+        if (run < 0){
+            if (!ready.sz){
+                if (k >= n) break;
+                if (cur != -1){ if (cur != -2 && seg_start < t) seg_push(sv,(Seg){.pid=cur,.start=(int)seg_start,.end=(int)t}); cur = -1; seg_start = t; }
+                t = pr[ord[k]].arrival < lim_t ? pr[ord[k]].arrival : lim_t;
+                continue;
+            }
+            run = ih_pop(&ready);
+            slice_end = t + quantum;
+        }
+        int i = run;
+        if (cur != pr[i].pid){ if (cur != -2 && seg_start < t) seg_push(sv,(Seg){.pid=cur,.start=(int)seg_start,.end=(int)t}); cur = pr[i].pid; seg_start = t; }
+
+        /* next event of the running job */
+        long long exec = pr[i].burst - rem[i], next = t + rem[i];
+        bool has_cs = csn[i] < cs->off[i+1];
+        if (has_cs){
+            long long at = hold[i] >= 0 ? cs->at[csn[i]] + cs->len[csn[i]] : cs->at[csn[i]];
+            if (t + at - exec < next) next = t + at - exec;
+        }
+        if (k < n && pr[ord[k]].arrival < next) next = pr[ord[k]].arrival;
+        if (!srtf && slice_end < next) next = slice_end;
+        if (lim_t < next) next = lim_t;
+        long long dt = next - t;
+        if (dt > 0 && start[i] < 0) start[i] = (int)t;   /* a job blocked at offset 0 has not responded yet */
+        if (srtf && blk.sz && dt > 0){
+            long long over = rem[i] - wkey[blk.h[0]];
+            if (over > 0){ long long v = over < dt ? over : dt; L.inversion += v; if (hold[i] < 0) L.inversion_unbounded += v; }
+        }
+        rem[i] -= (int)dt; t = next; exec += dt;
+
+        /* section exit, then completion, then section entry */
+        if (hold[i] >= 0 && exec == cs->at[csn[i]] + cs->len[csn[i]]){
+            Resource *r = &ls->r[hold[i]];
+            hold[i] = -1; csn[i]++; r->holder = -1;
+            if (r->wsz){
+                int w = w_pop(r, wkey);
+                ih_remove(&blk, w);
+                long long b = t - blocked_since[w]; blocked[w] += b; r->wait += b; L.blocked += b;
+                r->holder = w; hold[w] = cs->res[csn[w]]; r->acquisitions++;
+                MAKE_READY(w);
+            }
+        }
+        if (rem[i] == 0){
+            end[i] = (int)t; completed++; run = -1;
+            continue;
+        }
+        if (hold[i] < 0 && csn[i] < cs->off[i+1] && exec == cs->at[csn[i]]){
+            Resource *r = &ls->r[cs->res[csn[i]]];
+            if (r->holder < 0){ r->holder = i; hold[i] = cs->res[csn[i]]; r->acquisitions++; }
+            else {
+                r->contended++;
+                wkey[i] = srtf ? rem[i] : seq++;
+                w_push(r, wkey, i); ih_push(&blk, i);
+                blocked_since[i] = t; run = -1;
+                int h = r->holder;
+                if (srtf && protocol == LP_INHERIT && ready.pos[h] >= 0){ long long e = EFF(h); if (e < ekey[h]){ ekey[h] = e; ih_decrease(&ready, h); } }
+                continue;
+            }
+        }
+        if (!srtf && t >= slice_end){
+            while (k<n && pr[ord[k]].arrival <= t){ MAKE_READY(ord[k]); k++; }   /* arrivals queue ahead, as in sim_rr */
+            MAKE_READY(i); run = -1;
+        }
+    }
+    if (cur != -2 && seg_start < t) seg_push(sv,(Seg){.pid=cur,.start=(int)seg_start,.end=(int)t});
+    #undef MAKE_READY
+    #undef EFF
+    o->stop = (int)t; o->truncated = completed < n;
+    if (o->left) memcpy(o->left, rem, n*sizeof(int));
+    seg_coalesce(sv);
+    for (int j=0;j<n;j++) if (blocked[j] > L.blocked_max) L.blocked_max = blocked[j];
+    for (int r=0;r<ls->len;r++){ L.acquisitions += ls->r[r].acquisitions; L.contended += ls->r[r].contended; }
+    *ls_out = L;
+    ih_free(&ready); ih_free(&blk); free(ord);
+    free(rem); free(csn); free(hold); free(ekey); free(wkey); free(blocked_since); free(blocked);
+}
+
+static void run_locks(const Proc *pr, int n, int alg, int quantum, LockSet *ls, Csv *csv, const Config *cfg){
+    static const char *PROTO[] = {"none","inherit","ceiling"};
+    int protocol = alg == ALG_SRTF ? cfg->lock_protocol : LP_NONE;
+    char ALG[64];
+    if (alg == ALG_SRTF) snprintf(ALG, sizeof(ALG), "SRTF+locks(%s)", PROTO[protocol]);
+    else                 snprintf(ALG, sizeof(ALG), "RoundRobin(q=%d)+locks", quantum);
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    LockStats L;
+    sim_locks(pr, n, alg, quantum, protocol, ls, cfg, &o, &L);
+
+    printf("%s Scheduling =>\n", ALG);
+    report_run(ALG, pr, n, &o, csv, cfg);
+    printf("  Locks: %lld acquisitions, %lld contended; blocked time total %lld, mean %.2f/job, max %lld\n",
+           L.acquisitions, L.contended, L.blocked, n ? (double)L.blocked/n : 0.0, L.blocked_max);
+    if (alg == ALG_SRTF)
+        printf("  Priority inversion: %lld time units (%lld with a non-holder running)\n", L.inversion, L.inversion_unbounded);
+    int top[5], nt = 0;                       /* hottest resources by wait time */
+    for (int r=0;r<ls->len;r++){
+        if (!ls->r[r].wait || (nt == 5 && ls->r[top[4]].wait >= ls->r[r].wait)) continue;
+        int p = nt < 5 ? nt++ : 4;
+        for (; p > 0 && ls->r[top[p-1]].wait < ls->r[r].wait; p--) top[p] = top[p-1];
+        top[p] = r;
+    }
+    if (nt){
+        printf("  Most contended:");
+        for (int j=0;j<nt;j++) printf(" %s(wait %lld, %lld blocked)", ls->names[top[j]], ls->r[top[j]].wait, ls->r[top[j]].contended);
+        printf("\n");
+    }
+    printf("\n");
+    run_free(&o);
+}
+
+/* ===================== Gittins index ===================== */
+/* --gittins=FILE: lines of CLASS SIZE WEIGHT give each job class a discrete
+   size distribution, and the class column picks a job's class (default 0).
+   For a job of age a, the Gittins index is
+     G(a) = max over support points s > a of P(S <= s | S > a) / E[min(S, s) - a | S > a],
+   and the maximising s is the next breakpoint. At least until then the index
+   stays >= G(a). Tables of G and of the breakpoint for every age below the
+   largest size are computed at startup by a pool of threads. The engine is
+   preemptive. It re-reads the table only when the running job reaches its
+   breakpoint or an arrival challenges it, never per tick. Ages past the
+   largest size get index 0. */
+
+#define GIT_SCALE 1e15                 /* index -> IHeap key */
+#define GIT_MAX_TABLE (1 << 26)        /* total table entries across classes */
+#define GIT_CHUNK 4096                 /* ages per work item */
+
+typedef struct {
+    int C;
+    int *m, **size; double **prob;     /* per class support, ascending */
+    int *amax;                         /* table length = largest size */
+    double **g; int **brk;             /* per class and age */
+    atomic_int next;                   /* work cursor for the pool */
+} GitTab;
+
+static void *git_worker(void *arg){
+    GitTab *gt = (GitTab*)arg;
+    for (;;){
+        int w = atomic_fetch_add(&gt->next, 1), c = 0;
+        while (c < gt->C && w >= (gt->amax[c] + GIT_CHUNK - 1) / GIT_CHUNK){ w -= (gt->amax[c] + GIT_CHUNK - 1) / GIT_CHUNK; c++; }
+        if (c == gt->C) return NULL;
+        const int m = gt->m[c], *s = gt->size[c]; const double *p = gt->prob[c];
+        int lo = w * GIT_CHUNK, hi = lo + GIT_CHUNK < gt->amax[c] ? lo + GIT_CHUNK : gt->amax[c];
+        int first = 0;
+        while (first < m && s[first] <= lo) first++;
+        for (int a=lo; a<hi; a++){
+            while (s[first] <= a) first++;           /* first support point > a */
+            /* candidate s[i]: P(done by s[i]) / E[time until done or s[i]], both unnormalised */
+            double best = -1, mass = 0, tail = 0, before = 0; int bi = first;
+            for (int i=first;i<m;i++) tail += p[i];
+            for (int i=first;i<m;i++){
+                mass += p[i];
+                before += p[i] * (double)(s[i] - a);
+                double v = mass / (before + (tail - mass) * (double)(s[i] - a));
+                if (v > best){ best = v; bi = i; }
+            }
+            gt->g[c][a] = best; gt->brk[c][a] = s[bi];
+        }
+    }
+}
+
+static void git_load(GitTab *gt, const char *path){
+    memset(gt, 0, sizeof(*gt));
+    FILE *f = fopen(path, "r");
+    if (!f){ fprintf(stderr,"ERROR: cannot open %s\n", path); exit(1); }
+    typedef struct { int c, s; double w; } GLine;
+    GLine *v = NULL; int len = 0, cap = 0, c, s; double w;
+    while (fscanf(f, "%d %d %lf", &c, &s, &w) == 3){
+        if (c < 0 || c > 65535 || s <= 0 || w < 0){ fprintf(stderr,"ERROR: %s: need CLASS 0..65535, SIZE > 0, WEIGHT >= 0\n", path); exit(1); }
+        if (len == cap){ cap = cap ? cap*2 : 256; v = (GLine*)realloc(v, cap*sizeof(GLine)); if (!v){ fprintf(stderr,"OOM\n"); exit(1); } }
+        v[len++] = (GLine){ c, s, w };
+        if (c >= gt->C) gt->C = c + 1;
+    }
+    if (!feof(f)){ fprintf(stderr,"ERROR: %s: expected CLASS SIZE WEIGHT\n", path); exit(1); }
+    fclose(f);
+    gt->m = (int*)calloc(gt->C, sizeof(int)); gt->amax = (int*)calloc(gt->C, sizeof(int));
+    gt->size = (int**)calloc(gt->C, sizeof(int*)); gt->prob = (double**)calloc(gt->C, sizeof(double*));
+    gt->g = (double**)calloc(gt->C, sizeof(double*)); gt->brk = (int**)calloc(gt->C, sizeof(int*));
+    if (!gt->m||!gt->amax||!gt->size||!gt->prob||!gt->g||!gt->brk){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int e=0;e<len;e++) gt->m[v[e].c]++;
+    long long total = 0;
+    for (c=0;c<gt->C;c++){
+        gt->size[c] = (int*)malloc((gt->m[c] ? gt->m[c] : 1)*sizeof(int)); gt->prob[c] = (double*)malloc((gt->m[c] ? gt->m[c] : 1)*sizeof(double));
+        if (!gt->size[c] || !gt->prob[c]){ fprintf(stderr,"OOM\n"); exit(1); }
+        gt->m[c] = 0;
+    }
+    for (int e=0;e<len;e++){ c = v[e].c; gt->size[c][gt->m[c]] = v[e].s; gt->prob[c][gt->m[c]++] = v[e].w; }
+    free(v);
+    for (c=0;c<gt->C;c++){
+        int m = gt->m[c], *sz = gt->size[c]; double *pb = gt->prob[c], sum = 0;
+        for (int i=1;i<m;i++){                        /* insertion sort; supports are short */
+            int ks = sz[i]; double kp = pb[i]; int j = i - 1;
+            while (j >= 0 && sz[j] > ks){ sz[j+1] = sz[j]; pb[j+1] = pb[j]; j--; }
+            sz[j+1] = ks; pb[j+1] = kp;
+        }
+        int u = 0;                                    /* merge repeated sizes */
+        for (int i=0;i<m;i++){ if (u && sz[u-1] == sz[i]) pb[u-1] += pb[i]; else { sz[u] = sz[i]; pb[u++] = pb[i]; } }
+        gt->m[c] = m = u;
+        for (int i=0;i<m;i++) sum += pb[i];
+        if (m && sum <= 0){ fprintf(stderr,"ERROR: %s: class %d has zero total weight\n", path, c); exit(1); }
+        for (int i=0;i<m;i++) pb[i] /= sum;
+        gt->amax[c] = m ? sz[m-1] : 0;
+        total += gt->amax[c];
+        if (total > GIT_MAX_TABLE){ fprintf(stderr,"ERROR: %s: sizes too large for index tables (%d entries max)\n", path, GIT_MAX_TABLE); exit(1); }
+        gt->g[c] = (double*)malloc((gt->amax[c] ? gt->amax[c] : 1)*sizeof(double));
+        gt->brk[c] = (int*)malloc((gt->amax[c] ? gt->amax[c] : 1)*sizeof(int));
+        if (!gt->g[c] || !gt->brk[c]){ fprintf(stderr,"OOM\n"); exit(1); }
+    }
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nth = ncpu < 1 ? 1 : ncpu > 64 ? 64 : (int)ncpu;
+    pthread_t th[64];
+    atomic_init(&gt->next, 0);
+    for (int i=0;i<nth;i++) if (pthread_create(&th[i], NULL, git_worker, gt)){ fprintf(stderr,"ERROR: cannot start index worker\n"); exit(1); }
+    for (int i=0;i<nth;i++) pthread_join(th[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Gittins index tables: %d classes, %lld entries, %d threads, %.1f ms\n", gt->C, total, nth, 1e3 * ts_diff(&t0, &t1));
+}
+
+static void git_free(GitTab *gt){
+    for (int c=0;c<gt->C;c++){ free(gt->size[c]); free(gt->prob[c]); free(gt->g[c]); free(gt->brk[c]); }
+    free(gt->m); free(gt->amax); free(gt->size); free(gt->prob); free(gt->g); free(gt->brk);
+}
+
+/* IHeap key of job i at age a (smaller runs first) and the age where it must be re-read */
+static long long git_key(const GitTab *gt, int c, int a, int *brk){
+    if (a >= gt->amax[c]){ *brk = INT_MAX; return 0; }
+    *brk = gt->brk[c][a];
+    return -(long long)(gt->g[c][a] * GIT_SCALE);
+}
+
+/* audit key: the index behind an IHeap key, in millionths */
+static int git_audit_key(long long key){
+    double g = -(double)key / GIT_SCALE * 1e6;
+    return g >= INT32_MAX ? INT32_MAX : (int)llround(g);
+}
+
+static void sim_gittins(const Proc *pr, int n, const GitTab *gt, const int *cls, const Config *cfg, SimOut *o){
+    const char *ALG = "Gittins";
+    int *start = o->start, *end = o->end; SegVec *sv = o->sv;
+    const int lim_t = cfg->until; const long long lim_ev = cfg->max_events;
+    int *rem = o->left ? o->left : (int*)malloc(n*sizeof(int));
+    long long *key = (long long*)malloc(n*sizeof(long long));
+    int *brk = (int*)malloc(n*sizeof(int));
+    if (!rem || !key || !brk){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){ start[i] = end[i] = -1; rem[i] = pr[i].burst; }
+    int *ord = arrival_order(pr, n);
+    IHeap hp; ih_init(&hp, n, key, pr);
+    EngineStats st={0}; MetBatch mb; met_begin(&mb, cfg, ALG);
+    Audit *au = cfg->audit;
+    if (au) audit_emit(au, AUD_RUN, ALG_GITTINS, 0, n, -1, 0, 0, 0);
+
+    int t = 0, k = 0, completed = 0, last = -1;
+    if (n > 0 && pr[ord[0]].arrival > t) t = pr[ord[0]].arrival < lim_t ? pr[ord[0]].arrival : lim_t;
+    while (completed < n){
+        if (t >= lim_t || st.events >= lim_ev) break;
+        while (k < n && pr[ord[k]].arrival <= t){ int j = ord[k++]; key[j] = git_key(gt, cls[j], 0, &brk[j]); ih_push(&hp, j); st.events++; }
+        if (hp.sz > st.qdepth_max) st.qdepth_max = hp.sz;
+        if (!hp.sz){
+            int to = k < n ? (pr[ord[k]].arrival < lim_t ? pr[ord[k]].arrival : lim_t) : t;
+            if (to == t) break;
+            seg_push(sv, (Seg){.pid=-1, .start=t, .end=to}); st.idle += to - t; t = to;
+            continue;
+        }
+        int i = ih_pop(&hp);
+        if (start[i] == -1 && cfg->reneging && job_abandons(cfg, pr, i, t)){
+            end[i] = JOB_ABANDONED; rem[i] = 0; completed++;
+            if (au) audit_emit(au, AUD_ABANDON, ALG_GITTINS, pr[i].arrival + job_patience(cfg, i), pr[i].pid, -1, job_patience(cfg, i), 0, 0);
+            continue;
+        }
+        if (start[i] == -1) start[i] = t;
+        if (i != last){
+            st.dispatches++;
+            if (last >= 0 && rem[last] > 0){
+                st.preemptions++;
+                if (au) audit_emit(au, AUD_PREEMPT, ALG_GITTINS, t, pr[last].pid, pr[i].pid, rem[last], git_audit_key(key[i]), hp.sz + 1);
+            }
+            if (au){
+                int r = hp.sz ? hp.h[0] : -1;
+                audit_emit(au, AUD_DISPATCH, ALG_GITTINS, t, pr[i].pid, r < 0 ? -1 : pr[r].pid, git_audit_key(key[i]), r < 0 ? 0 : git_audit_key(key[r]), hp.sz + 1);
+            }
+            last = i;
+        }
+        st.qdepth = hp.sz;
+        if (++st.events >= mb.next) met_flush(&mb, &st);
+        /* run until completion, the breakpoint, or an arrival that outranks the current index */
+        int stop = brk[i] == INT_MAX ? INT_MAX : t + (brk[i] - (pr[i].burst - rem[i]));
+        if (t + rem[i] < stop) stop = t + rem[i];
+        if (lim_t < stop) stop = lim_t;
+        int run_to = stop;
+        while (k < n && pr[ord[k]].arrival < stop){
+            int at = pr[ord[k]].arrival, j = ord[k++], b;
+            key[j] = git_key(gt, cls[j], 0, &brk[j]); ih_push(&hp, j); st.events++;
+            if (key[j] < git_key(gt, cls[i], pr[i].burst - rem[i] + (at - t), &b)){ run_to = at; break; }
+        }
+        seg_push(sv, (Seg){.pid=pr[i].pid, .start=t, .end=run_to});
+        rem[i] -= run_to - t; t = run_to;
+        if (!rem[i]){
+            end[i] = t; completed++; st.completions++;
+            if (au) audit_emit(au, AUD_COMPLETE, ALG_GITTINS, t, pr[i].pid, -1, pr[i].burst, 0, 0);
+            continue;
+        }
+        key[i] = git_key(gt, cls[i], pr[i].burst - rem[i], &brk[i]);
+        ih_push(&hp, i);
+    }
+    o->stop = t; o->truncated = completed < n;
+    met_end(&mb, &st, pr, n, start, end);
+    seg_coalesce(sv);
+    ih_free(&hp); free(ord); free(key); free(brk);
+    if (rem != o->left) free(rem);
+}
+
+static void run_gittins(const Proc *pr, int n, const GitTab *gt, Csv *csv, const Config *cfg){
+    const char *ALG = "Gittins";
+    const int *cc = cfg->ext ? cfg->ext->v[COL_CLASS] : NULL;
+    int *cls = (int*)calloc(n, sizeof(int));
+    if (!cls){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){
+        cls[i] = cc ? cc[i] : 0;
+        if (cls[i] < 0 || cls[i] >= gt->C || !gt->m[cls[i]]){ fprintf(stderr,"ERROR: P%d class %d has no size distribution\n", pr[i].pid, cls[i]); exit(1); }
+    }
+    SegVec sv={0}; SimOut o = run_alloc(n, cfg, &sv);
+    sim_gittins(pr, n, gt, cls, cfg, &o);
+
+    printf("Gittins Index (%d classes) Scheduling =>\n", gt->C);
+    report_run(ALG, pr, n, &o, csv, cfg);
+    run_free(&o); free(cls);
+}
+
+/* ===================== Workload profile ===================== */
+
+/* A busy period is a maximal run of back-to-back work; it is the same for
+   every work-conserving single-CPU policy, so periods can be simulated in
+   isolation. `first` indexes into the arrival order. */
+typedef struct { int first, count; long long start, work; } BusyPeriod;
+typedef struct { BusyPeriod *a; int len, cap; } BusyVec;
+
+static void busy_push(BusyVec *v, BusyPeriod b){
+    if (v->len == v->cap){
+        int ncap = v->cap ? v->cap*2 : 64;
+        BusyPeriod *na = (BusyPeriod*)realloc(v->a, ncap*sizeof(BusyPeriod));
+        if (!na){ fprintf(stderr,"OOM\n"); exit(1); }
+        v->a = na; v->cap = ncap;
+    }
+    v->a[v->len++] = b;
+}
+
+/* One linear scan over the arrival order. */
+static void find_busy_periods(const Proc *pr, const int *ord, int n, BusyVec *out){
+    out->len = 0;
+    long long free_at = LLONG_MIN;
+    for (int k=0;k<n;k++){
+        const Proc *p = &pr[ord[k]];
+        if (p->arrival >= free_at){
+            busy_push(out, (BusyPeriod){ .first=k, .count=0, .start=p->arrival, .work=0 });
+            free_at = p->arrival;
+        }
+        BusyPeriod *b = &out->a[out->len-1];
+        b->count++; b->work += p->burst;
+        free_at += p->burst;
+    }
+}
+
+static int cmp_ll(const void *a, const void *b){
+    long long x = *(const long long*)a, y = *(const long long*)b;
+    return (x > y) - (x < y);
+}
+
+/* nth_element: reorder v so v[k] is the k-th smallest, smaller values
+   before it and larger ones after (Hoare partition, median-of-three). */
+static void select_kth(int *v, int n, int k){
+    int lo = 0, hi = n - 1;
+    while (lo < hi){
+        int mid = lo + (hi - lo) / 2, a = v[lo], b = v[mid], c = v[hi];
+        int piv = a < b ? (b < c ? b : a < c ? c : a) : (a < c ? a : b < c ? c : b);
+        int i = lo, j = hi;
+        while (i <= j){
+            while (v[i] < piv) i++;
+            while (v[j] > piv) j--;
+            if (i <= j){ int x = v[i]; v[i] = v[j]; v[j] = x; i++; j--; }
+        }
+        if (k <= j) hi = j; else if (k >= i) lo = i; else return;
+    }
+}
+
+#define PROFILE_MAX_WINDOWS (1 << 24)  /* arrival-count windows; a smaller --profile-window is widened */
+
+static void profile_workload(const Proc *pr, int n, const Config *cfg){
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    /* pass 1: branch-free reductions, vectorisable */
+    int amin = INT_MAX, amax = INT_MIN, bmax = 0;
+    double s1 = 0, s2 = 0, s3 = 0;
+    for (int i=0;i<n;i++){
+        int a = pr[i].arrival; double b = pr[i].burst;
+        amin = a < amin ? a : amin;
+        amax = a > amax ? a : amax;
+        bmax = pr[i].burst > bmax ? pr[i].burst : bmax;
+        s1 += b; s2 += b*b; s3 += b*b*b;
+    }
+    double mean = s1/n, var = s2/n - mean*mean; if (var < 0) var = 0;
+    double sd = sqrt(var), cv = mean > 0 ? sd/mean : 0;
+    double skew = sd > 0 ? (s3/n - 3*mean*var - mean*mean*mean) / (var*sd) : 0;
+    long long span = (long long)amax - amin;
+    double rate = span > 0 ? (double)(n-1)/span : 0;
+    double load = rate * mean;
+
+    /* pass 2: arrival counts per window */
+    long long W = cfg->profile_window > 0 ? cfg->profile_window : (span*10/n > 0 ? span*10/n : 1);
+    if (span / W >= PROFILE_MAX_WINDOWS){
+        long long w = span / PROFILE_MAX_WINDOWS + 1;
+        fprintf(stderr,"WARNING: --profile-window=%lld gives more than %d windows over span %lld; using %lld\n", W, PROFILE_MAX_WINDOWS, span, w);
+        W = w;
+    }
+    long long nb = span/W + 1;
+    long long *cnt = (long long*)calloc(nb, sizeof(long long));
+    if (!cnt){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++) cnt[(pr[i].arrival - amin)/W]++;
+    long long nfull = nb > 1 ? nb-1 : 1;   /* the last window is cut short by amax */
+    double c1 = 0, c2 = 0;
+    for (long long w=0; w<nfull; w++){ c1 += cnt[w]; c2 += (double)cnt[w]*cnt[w]; }
+    double cm = c1/nfull, idc = cm > 0 ? (c2/nfull - cm*cm)/cm : 0;
+
+    /* Hill estimator over the largest kh+1 bursts, selected after the passes
+       above so they stay straight reductions. On large traces the (kh+1)-th
+       largest of every 8th burst is a lower bound for the true threshold;
+       a branch-free compaction keeps the bursts at or above it and the
+       selection then runs on those alone. */
+    int kh = n/100; if (kh < 10) kh = 10; if (kh > 10000) kh = 10000; if (kh > n-1) kh = n-1;
+    double hill = 0;
+    if (kh > 0){
+        int *bs = (int*)malloc(n*sizeof(int)), m = n;
+        if (!bs){ fprintf(stderr,"OOM\n"); exit(1); }
+        if (n / 8 > 8 * (kh+1)){
+            int ns = n / 8;
+            for (int j=0;j<ns;j++) bs[j] = pr[8*j].burst;
+            select_kth(bs, ns, ns-kh-1);
+            int lb = bs[ns-kh-1];
+            m = 0;
+            for (int i=0;i<n;i++){ bs[m] = pr[i].burst; m += pr[i].burst >= lb; }
+        } else for (int i=0;i<n;i++) bs[i] = pr[i].burst;
+        select_kth(bs, m, m-kh-1);
+        const int *top = bs + (m-kh-1);   /* top[0] is the threshold, the rest are above it */
+        double sl = 0;
+        for (int j=0;j<=kh;j++) sl += log((double)top[j] / top[0]);
+        hill = sl > 0 ? kh / sl : INFINITY;
+        free(bs);
+    }
+
+    /* busy periods */
+    int *ord = arrival_order(pr, n);
+    BusyVec bv = {0}; find_busy_periods(pr, ord, n, &bv);
+    long long *len = (long long*)malloc(bv.len*sizeof(long long));
+    if (!len){ fprintf(stderr,"OOM\n"); exit(1); }
+    double lsum = 0; int jmax = 0;
+    for (int b=0;b<bv.len;b++){ len[b] = bv.a[b].work; lsum += len[b]; if (bv.a[b].count > jmax) jmax = bv.a[b].count; }
+    qsort(len, bv.len, sizeof(long long), cmp_ll);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    printf("Workload profile (n=%d, %.2f ms):\n", n, ts_diff(&t0, &t1)*1e3);
+    printf("  Arrivals    : span [%d,%d], rate %.4f/unit, index of dispersion %.3f (window %lld)\n", amin, amax, rate, idc, W);
+    printf("  Offered load: %.4f\n", load);
+    printf("  Burst       : mean %.3f, sd %.3f, CV %.3f, skew %.3f, max %d\n", mean, sd, cv, skew, bmax);
+    printf("  Tail        : Hill alpha %.3f (top %d)\n", hill, kh);
+    printf("  Busy periods: %d, length mean %.2f p50 %lld p90 %lld p99 %lld max %lld, jobs/period mean %.2f max %d\n\n",
+           bv.len, lsum/bv.len, len[bv.len/2], len[(long long)bv.len*9/10], len[(long long)bv.len*99/100], len[bv.len-1],
+           (double)n/bv.len, jmax);
+
+    free(len); free(bv.a); free(ord); free(cnt);
+}
+
+/* ===================== Policy dispatch ===================== */
+
+typedef struct { int alg; int quantum; char name[32]; } Policy;
+
+static void policy_set(Policy *p, int alg, int quantum){
+    static const char *NAMES[] = {"FCFS","SJF","SRTF","RR"};
+    p->alg = alg; p->quantum = quantum;
+    if (alg == ALG_RR) snprintf(p->name, sizeof(p->name), "RR(q=%d)", quantum);
+    else               snprintf(p->name, sizeof(p->name), "%s", NAMES[alg]);
+}
+
+static void sim_policy(const Policy *p, const Proc *pr, int n, const Config *cfg, SimOut *o){
+    switch (p->alg){
+    case ALG_FCFS: sim_fcfs(pr, n, cfg, o); break;
+    case ALG_SJF:  sim_sjf (pr, n, cfg, o); break;
+    case ALG_SRTF: sim_srtf(pr, n, cfg, o); break;
+    default:       sim_rr  (pr, n, p->quantum, cfg, o); break;
+    }
+}
+
+/* Copy of cfg with the side channels (metrics, audit) detached and no run
+   limits, for pilot and sampled runs that must not show up as real runs. */
+static Config quiet_config(const Config *cfg){
+    Config q = *cfg; q.metrics = NULL; q.audit = NULL;
+    q.until = INT_MAX; q.max_events = LLONG_MAX;
+    return q;
+}
+
+/* ===================== Random numbers ===================== */
+
+static uint64_t rng_next(uint64_t *s){   /* splitmix64 */
+    uint64_t z = (*s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+static double rng_unif(uint64_t *s){ return (rng_next(s) >> 11) * (1.0/9007199254740992.0); }
+static int rng_below(uint64_t *s, int m){ return (int)(rng_unif(s) * m); }
+
+/* ===================== Busy-period sampling ===================== */
+/* Busy periods are stratified by job count (floor(log2)), then a fraction of
+   each stratum is drawn without replacement; strata with at most `min_per`
+   periods are taken whole (census). Weights N_h/m_h expand sample totals. */
+
+#define BP_STRATA 32
+
+typedef struct {
+    int N[BP_STRATA], m[BP_STRATA];
+    int *pick;            /* sampled busy-period ids, grouped by stratum */
+    int *pick_h;          /* stratum of each pick */
+    int npick;
+    long long jobs;       /* jobs inside the picked periods */
+} BpSample;
+
+static int bp_stratum(int count){ return 31 - __builtin_clz((unsigned)count); }
+
+static void bp_sample(const BusyVec *bv, double frac, int min_per, uint64_t *rng, BpSample *out){
+    memset(out, 0, sizeof(*out));
+    int off[BP_STRATA+1] = {0};
+    for (int b=0;b<bv->len;b++) out->N[bp_stratum(bv->a[b].count)]++;
+    for (int h=0;h<BP_STRATA;h++) off[h+1] = off[h] + out->N[h];
+    int *byh = (int*)malloc((bv->len ? bv->len : 1)*sizeof(int));
+    out->pick = (int*)malloc((bv->len ? bv->len : 1)*sizeof(int));
+    out->pick_h = (int*)malloc((bv->len ? bv->len : 1)*sizeof(int));
+    if (!byh || !out->pick || !out->pick_h){ fprintf(stderr,"OOM\n"); exit(1); }
+    int fill[BP_STRATA]; memcpy(fill, off, sizeof(fill));
+    for (int b=0;b<bv->len;b++) byh[fill[bp_stratum(bv->a[b].count)]++] = b;
+    for (int h=0;h<BP_STRATA;h++){
+        int N = out->N[h]; if (!N) continue;
+        int m = (int)ceil(frac * N);
+        if (m < min_per) m = min_per;
+        if (m > N) m = N;
+        out->m[h] = m;
+        int *grp = byh + off[h];
+        for (int j=0;j<m;j++){            /* partial Fisher-Yates */
+            int r = j + rng_below(rng, N - j);
+            int x = grp[j]; grp[j] = grp[r]; grp[r] = x;
+            out->pick[out->npick] = grp[j]; out->pick_h[out->npick] = h; out->npick++;
+            out->jobs += bv->a[grp[j]].count;
+        }
+    }
+    free(byh);
+}
+static void bp_sample_free(BpSample *s){ free(s->pick); free(s->pick_h); }
+static bool bp_sample_census(const BpSample *s){
+    for (int h=0;h<BP_STRATA;h++) if (s->m[h] < s->N[h]) return false;
+    return true;
+}
+
+/* Per (policy, sampled period) sums; the job values are kept for quantiles. */
+typedef struct { double resp, wait, tat, sd, sd2; int count; } BpSums;
+
+static Proc *bp_extract(const Proc *pr, const int *ord, const BusyPeriod *b, Proc *buf){
+    for (int j=0;j<b->count;j++) buf[j] = pr[ord[b->first + j]];
+    return buf;
+}
+
+/* Bootstrap multiplicities: resample each non-census stratum with replacement. */
+static void bp_resample(const BpSample *s, uint64_t *rng, int *mult){
+    int i = 0;
+    for (int h=0;h<BP_STRATA;h++){
+        int m = s->m[h]; if (!m) continue;
+        if (m == s->N[h]){ for (int j=0;j<m;j++) mult[i+j] = 1; }
+        else {
+            for (int j=0;j<m;j++) mult[i+j] = 0;
+            for (int j=0;j<m;j++) mult[i + rng_below(rng, m)]++;
+        }
+        i += m;
+    }
+}
+
+/* ===================== Recommender ===================== */
+
+#define REC_BOOT 200
+
+typedef struct { double v; int p; } ValPick;
+static int cmp_valpick(const void *a, const void *b){
+    double x = ((const ValPick*)a)->v, y = ((const ValPick*)b)->v;
+    return (x > y) - (x < y);
+}
+
+/* Objective as "lower is better"; fairness is Jain's index over slowdowns,
+   negated. w[p] is the expansion weight of pick p. */
+static double rec_score(int obj, const BpSums *sums, const ValPick *vals, int nvals, int npick, const double *w){
+    double cnt = 0, a = 0, b = 0;
+    for (int p=0;p<npick;p++){
+        cnt += w[p] * sums[p].count;
+        if (obj == OBJ_MEAN_RESP) a += w[p] * sums[p].resp;
+        else if (obj == OBJ_FAIRNESS){ a += w[p] * sums[p].sd; b += w[p] * sums[p].sd2; }
+    }
+    if (cnt <= 0) return 0;
+    if (obj == OBJ_MEAN_RESP) return a / cnt;
+    if (obj == OBJ_FAIRNESS)  return b > 0 ? -(a*a) / (cnt*b) : -1.0;
+    double target = 0.99 * cnt, acc = 0;
+    for (int j=0;j<nvals;j++){ acc += w[vals[j].p]; if (acc >= target) return vals[j].v; }
+    return nvals ? vals[nvals-1].v : 0;
+}
+
+static double rec_exact(int obj, const Proc *pr, int n, const int *start, const int *end){
+    BpSums s = {0}; ValPick *vals = NULL;
+    if (obj == OBJ_P99_TAT){ vals = (ValPick*)malloc(n*sizeof(ValPick)); if (!vals){ fprintf(stderr,"OOM\n"); exit(1); } }
+    for (int i=0;i<n;i++){
+        double tat = end[i] - pr[i].arrival, sd = tat / pr[i].burst;
+        s.resp += start[i] - pr[i].arrival; s.sd += sd; s.sd2 += sd*sd; s.count++;
+        if (vals) vals[i] = (ValPick){ tat, 0 };
+    }
+    if (vals) qsort(vals, n, sizeof(ValPick), cmp_valpick);
+    double w = 1, r = rec_score(obj, &s, vals, vals ? n : 0, 1, &w);
+    free(vals);
+    return r;
+}
+
+static int cmp_double(const void *a, const void *b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+static double pct_of(double *v, int m, double q){
+    qsort(v, m, sizeof(double), cmp_double);
+    int k = (int)(q * (m-1) + 0.5);
+    return v[k];
+}
+
+static int build_policies(const Config *cfg, const int *quanta, int nq, Policy *out){
+    int k = 0;
+    if (cfg->run_fcfs) policy_set(&out[k++], ALG_FCFS, 0);
+    if (cfg->run_sjf)  policy_set(&out[k++], ALG_SJF, 0);
+    if (cfg->run_srtf) policy_set(&out[k++], ALG_SRTF, 0);
+    if (cfg->run_rr)   for (int j=0;j<nq;j++) policy_set(&out[k++], ALG_RR, quanta[j]);
+    return k;
+}
+
+static void recommend(const Proc *pr, int n, const Config *cfg){
+    static const char *OBJ[] = {"", "mean response", "p99 turnaround", "fairness (Jain, slowdown)"};
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+    Config q = quiet_config(cfg);
+    int obj = cfg->recommend;
+
+    Policy pol[4 + 16];
+    int np = build_policies(cfg, cfg->rec_quanta, cfg->nrec_quanta, pol);
+    if (np == 0){ fprintf(stderr,"ERROR: no candidate policies selected\n"); exit(1); }
+
+    int *ord = arrival_order(pr, n);
+    BusyVec bv = {0}; find_busy_periods(pr, ord, n, &bv);
+    uint64_t rng = cfg->seed;
+    BpSample smp; bp_sample(&bv, cfg->sample_frac, 2, &rng, &smp);
+
+    int maxc = 0; for (int p=0;p<smp.npick;p++) if (bv.a[smp.pick[p]].count > maxc) maxc = bv.a[smp.pick[p]].count;
+    Proc *buf = (Proc*)malloc(maxc*sizeof(Proc));
+    int *st = (int*)malloc(maxc*sizeof(int)), *en = (int*)malloc(maxc*sizeof(int));
+    BpSums *sums = (BpSums*)calloc((size_t)np*smp.npick, sizeof(BpSums));
+    ValPick *vals = obj == OBJ_P99_TAT ? (ValPick*)malloc((size_t)np*smp.jobs*sizeof(ValPick)) : NULL;
+    double *w = (double*)malloc(smp.npick*sizeof(double));
+    int *mult = (int*)malloc(smp.npick*sizeof(int));
+    double *boot = (double*)malloc((size_t)np*REC_BOOT*sizeof(double));
+    if (!buf||!st||!en||!sums||(obj==OBJ_P99_TAT && !vals)||!w||!mult||!boot){ fprintf(stderr,"OOM\n"); exit(1); }
+
+    /* pilots: every candidate on the same sampled periods (paired comparison) */
+    for (int c=0;c<np;c++){
+        long long nv = 0;
+        for (int p=0;p<smp.npick;p++){
+            const BusyPeriod *b = &bv.a[smp.pick[p]];
+            Proc *sub = bp_extract(pr, ord, b, buf);
+            SimOut so; simout_init(&so, st, en, NULL, NULL);
+            sim_policy(&pol[c], sub, b->count, &q, &so);
+            BpSums *s = &sums[(size_t)c*smp.npick + p];
+            for (int j=0;j<b->count;j++){
+                double tat = en[j] - sub[j].arrival, sd = tat / sub[j].burst;
+                s->resp += st[j] - sub[j].arrival; s->tat += tat; s->wait += tat - sub[j].burst;
+                s->sd += sd; s->sd2 += sd*sd; s->count++;
+                if (vals) vals[(size_t)c*smp.jobs + nv++] = (ValPick){ tat, p };
+            }
+        }
+        if (vals) qsort(vals + (size_t)c*smp.jobs, smp.jobs, sizeof(ValPick), cmp_valpick);
+    }
+
+    double est[4 + 16];
+    for (int p=0;p<smp.npick;p++){ int h = smp.pick_h[p]; w[p] = (double)smp.N[h] / smp.m[h]; }
+    for (int c=0;c<np;c++) est[c] = rec_score(obj, sums + (size_t)c*smp.npick, vals ? vals + (size_t)c*smp.jobs : NULL, (int)smp.jobs, smp.npick, w);
+    for (int r=0;r<REC_BOOT;r++){
+        bp_resample(&smp, &rng, mult);
+        for (int p=0;p<smp.npick;p++){ int h = smp.pick_h[p]; w[p] = (double)smp.N[h] / smp.m[h] * mult[p]; }
+        for (int c=0;c<np;c++)
+            boot[(size_t)c*REC_BOOT + r] = rec_score(obj, sums + (size_t)c*smp.npick, vals ? vals + (size_t)c*smp.jobs : NULL, (int)smp.jobs, smp.npick, w);
+    }
+
+    int best = 0; for (int c=1;c<np;c++) if (est[c] < est[best]) best = c;
+    bool census = bp_sample_census(&smp);
+    bool tied[4 + 16] = {false}; int ntied = 0;
+    double *d = (double*)malloc(REC_BOOT*sizeof(double)), lo[4 + 16], hi[4 + 16];
+    if (!d){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int c=0;c<np;c++){
+        for (int r=0;r<REC_BOOT;r++) d[r] = boot[(size_t)c*REC_BOOT + r];
+        lo[c] = pct_of(d, REC_BOOT, 0.025); hi[c] = pct_of(d, REC_BOOT, 0.975);
+        if (c == best){ tied[c] = true; ntied++; continue; }
+        if (census) continue;
+        for (int r=0;r<REC_BOOT;r++) d[r] = boot[(size_t)c*REC_BOOT + r] - boot[(size_t)best*REC_BOOT + r];
+        if (pct_of(d, REC_BOOT, 0.025) <= 0){ tied[c] = true; ntied++; }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double pilot_ms = ts_diff(&t0, &t1)*1e3;
+
+    /* escalate statistically tied candidates to full simulation */
+    long long simulated = (long long)np * smp.jobs;
+    double exact[4 + 16];
+    int winner = best;
+    if (ntied > 1){
+        int *fs = (int*)malloc(n*sizeof(int)), *fe = (int*)malloc(n*sizeof(int));
+        if (!fs||!fe){ fprintf(stderr,"OOM\n"); exit(1); }
+        winner = -1;
+        for (int c=0;c<np;c++){
+            if (!tied[c]) continue;
+            SimOut so; simout_init(&so, fs, fe, NULL, NULL);
+            sim_policy(&pol[c], pr, n, &q, &so);
+            exact[c] = rec_exact(obj, pr, n, fs, fe);
+            simulated += n;
+            if (winner < 0 || exact[c] < exact[winner]) winner = c;
+        }
+        free(fs); free(fe);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double sgn = obj == OBJ_FAIRNESS ? -1 : 1;
+    printf("Recommendation for %s (%d of %d busy periods sampled, %lld of %d jobs):\n",
+           OBJ[obj], smp.npick, bv.len, smp.jobs, n);
+    printf("  %-12s %12s   %-25s %s\n", "Policy", "Estimate", "95% CI", "");
+    for (int c=0;c<np;c++){
+        double a = sgn*lo[c], b = sgn*hi[c]; if (a > b){ double x=a; a=b; b=x; }
+        printf("  %-12s %12.4f   [%10.4f, %10.4f]", pol[c].name, sgn*est[c], a, b);
+        if (ntied > 1 && tied[c]) printf("   tied, full run: %.4f", sgn*exact[c]);
+        printf("\n");
+    }
+    if (ntied > 1) printf("  => %s (escalated %d statistically tied candidates to full simulation)\n", pol[winner].name, ntied);
+    else           printf("  => %s%s\n", pol[winner].name, census ? " (all busy periods simulated, exact)" : " (clear winner from pilots)");
+    long long full = (long long)np * n;
+    printf("  Compute: %lld job-simulations vs %lld for a full sweep (%.1f%% saved); pilots %.2f ms, total %.2f ms\n\n",
+           simulated, full, full ? 100.0*(full - simulated)/full : 0.0, pilot_ms, ts_diff(&t0, &t1)*1e3);
+
+    free(d); free(boot); free(mult); free(w); free(vals); free(sums); free(en); free(st); free(buf);
+    bp_sample_free(&smp); free(bv.a); free(ord);
+}
+
+/* ===================== Sampled simulation ===================== */
+/* Estimates per-job means from a stratified sample of busy periods. Each
+   metric is a ratio (sum over jobs / job count); its variance uses the usual
+   linearised stratified estimator with finite-population correction. With
+   --sample-error=E the fraction is doubled until every 95% half-width is
+   within E relative (or all periods are simulated). */
+
+static void strat_ratio(const BpSample *s, const double *y, const double *x, double *est, double *half){
+    double Y = 0, X = 0;
+    for (int p=0;p<s->npick;p++){ int h = s->pick_h[p]; double w = (double)s->N[h] / s->m[h]; Y += w*y[p]; X += w*x[p]; }
+    double R = X > 0 ? Y / X : 0, var = 0;
+    int p = 0;
+    for (int h=0;h<BP_STRATA;h++){
+        int m = s->m[h]; if (!m) continue;
+        double mean = 0, ss = 0;
+        for (int j=0;j<m;j++) mean += y[p+j] - R*x[p+j];
+        mean /= m;
+        for (int j=0;j<m;j++){ double e = y[p+j] - R*x[p+j] - mean; ss += e*e; }
+        if (m > 1) var += (double)s->N[h]*s->N[h] * (1.0 - (double)m/s->N[h]) * (ss/(m-1)) / m;
+        p += m;
+    }
+    *est = R;
+    *half = X > 0 ? 1.96 * sqrt(var) / X : 0;
+}
+
+static void sample_run(const Proc *pr, int n, const Config *cfg){
+    Config q = quiet_config(cfg);
+    Policy pol[4];
+    int np = build_policies(cfg, &cfg->quantum, 1, pol);
+
+    int *ord = arrival_order(pr, n);
+    BusyVec bv = {0}; find_busy_periods(pr, ord, n, &bv);
+    int maxc = 0; for (int b=0;b<bv.len;b++) if (bv.a[b].count > maxc) maxc = bv.a[b].count;
+    Proc *buf = (Proc*)malloc(maxc*sizeof(Proc));
+    int *st = (int*)malloc(maxc*sizeof(int)), *en = (int*)malloc(maxc*sizeof(int));
+    double *y = (double*)malloc(3*(size_t)bv.len*sizeof(double)), *x = (double*)malloc(bv.len*sizeof(double));
+    if (!buf||!st||!en||!y||!x){ fprintf(stderr,"OOM\n"); exit(1); }
+
+    for (int c=0;c<np;c++){
+        struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+        double frac = cfg->sample_frac;
+        double est[3], half[3];
+        BpSample smp; long long simulated = 0;
+        for (;;){
+            uint64_t rng = cfg->seed;
+            bp_sample(&bv, frac, 2, &rng, &smp);
+            for (int p=0;p<smp.npick;p++){
+                const BusyPeriod *b = &bv.a[smp.pick[p]];
+                Proc *sub = bp_extract(pr, ord, b, buf);
+                SimOut so; simout_init(&so, st, en, NULL, NULL);
+                sim_policy(&pol[c], sub, b->count, &q, &so);
+                double r = 0, w = 0, t = 0;
+                for (int j=0;j<b->count;j++){
+                    int tat = en[j] - sub[j].arrival;
+                    r += st[j] - sub[j].arrival; t += tat; w += tat - sub[j].burst;
+                }
+                y[p] = r; y[bv.len + p] = w; y[2*(size_t)bv.len + p] = t; x[p] = b->count;
+            }
+            simulated += smp.jobs;
+            bool ok = true;
+            for (int m=0;m<3;m++){
+                strat_ratio(&smp, y + (size_t)m*bv.len, x, &est[m], &half[m]);
+                if (cfg->sample_error > 0 && est[m] > 0 && half[m] > cfg->sample_error * est[m]) ok = false;
+            }
+            if (ok || bp_sample_census(&smp) || frac >= 1) break;
+            bp_sample_free(&smp);
+            frac = frac*2 < 1 ? frac*2 : 1;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        printf("Sampled %s (%d of %d busy periods, %lld of %d jobs, fraction %.4g, %.2f ms):\n",
+               pol[c].name, smp.npick, bv.len, smp.jobs, n, frac, ts_diff(&t0, &t1)*1e3);
+        static const char *LBL[3] = {"Response:  ", "Waiting :  ", "Turnaround:"};
+        for (int m=0;m<3;m++)
+            printf("  %s%.2f +/- %.2f  [%.2f, %.2f]\n", LBL[m], est[m], half[m], est[m]-half[m], est[m]+half[m]);
+        if (simulated > smp.jobs) printf("  (%lld job-simulations including refinement rounds)\n", simulated);
+        printf("\n");
+        bp_sample_free(&smp);
+    }
+    free(x); free(y); free(en); free(st); free(buf); free(bv.a); free(ord);
+}
+
+/* ===================== Cluster simulation ===================== */
+/* --cluster=N: a front-end dispatcher assigns each arriving job to one of N
+   nodes, and every node runs its own stepper with --node-algo. Nodes only
+   interact through the dispatcher, so a node is advanced lazily, when a job is
+   sent to it or its state is inspected. JSQ needs every node's job count at
+   each arrival, so it keeps node completions in time order through a min-tree
+   over next-event times. LWL tracks each node's drain time (work left is
+   max(0, drain - now) for a work-conserving node). JSQ and LWL pick from
+   min-trees; JSQ breaks ties by least recent assignment (the key packs the
+   count above a 40-bit assignment stamp), LWL by longest idle. */
+
+#define JSQ_STAMP ((1LL<<40) - 1)
+
+typedef struct { int size; const long long *key; int *t; } MinTree;
+
+static int mt_pick(const MinTree *m, int a, int b){
+    if (a < 0) return b;
+    if (b < 0) return a;
+    return m->key[b] < m->key[a] ? b : a;          /* a is always the left (lower) side */
+}
+static void mt_init(MinTree *m, int n, const long long *key){
+    m->size = 1; while (m->size < n) m->size <<= 1;
+    m->key = key;
+    m->t = (int*)malloc(2*m->size*sizeof(int));
+    if (!m->t){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<m->size;i++) m->t[m->size+i] = i < n ? i : -1;
+    for (int p=m->size-1;p>0;p--) m->t[p] = mt_pick(m, m->t[2*p], m->t[2*p+1]);
+}
+static void mt_update(MinTree *m, int i){
+    for (int p = (m->size+i) >> 1; p; p >>= 1) m->t[p] = mt_pick(m, m->t[2*p], m->t[2*p+1]);
+}
+static int mt_min(const MinTree *m){ return m->t[1]; }
+/* Leftmost leaf below hi whose key is <= lim, or -1; p spans [lo, lo+span). */
+static int mt_first_le(const MinTree *m, int p, int lo, int span, int hi, long long lim){
+    if (lo >= hi || m->t[p] < 0 || m->key[m->t[p]] > lim) return -1;
+    if (p >= m->size) return m->t[p];
+    int r = mt_first_le(m, 2*p, lo, span/2, hi, lim);
+    return r >= 0 ? r : mt_first_le(m, 2*p+1, lo + span/2, span/2, hi, lim);
+}
+
+static void cluster_run(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    static const char *DSP[] = {"random","rr","jsq","pod","lwl"};
+    static const char *ALGN[] = {"FCFS","SJF","SRTF","RR"};
+    struct timespec t0, t1; clock_gettime(CLOCK_MONOTONIC, &t0);
+    const int N = cfg->cluster, alg = cfg->node_algo, D = cfg->dispatch;
+    Stepper *node = (Stepper*)malloc(N*sizeof(Stepper));
+    StreamAcc *acc = (StreamAcc*)malloc(N*sizeof(StreamAcc));
+    long long *cnt = (long long*)calloc(N, sizeof(long long)), *nxt = (long long*)malloc(N*sizeof(long long));
+    long long *drain = (long long*)calloc(N, sizeof(long long)), *work = (long long*)calloc(N, sizeof(long long));
+    if (!node||!acc||!cnt||!nxt||!drain||!work){ fprintf(stderr,"OOM\n"); exit(1); }
+    char ALG[64]; snprintf(ALG, sizeof(ALG), "Cluster(%s)/%s", DSP[D], ALGN[alg]);
+    OutBuf *nt = csv->norm ? norm_file(csv->norm, ALG) : NULL;     /* one --norm table for all nodes */
+    long long row0 = csv->norm ? csv->norm->row_base : 0;
+    for (int i=0;i<N;i++){
+        snprintf(acc[i].alg, sizeof(acc[i].alg), "Cluster(%s)/%s@%d", DSP[D], ALGN[alg], i);
+        acc[i].csv = csv; acc[i].norm = nt; acc[i].sr = acc[i].sw = acc[i].st = 0; acc[i].done = 0;
+        stp_init(&node[i], alg, cfg->quantum, NULL, stream_done, &acc[i]);
+        nxt[i] = INT_MAX;
+    }
+    MinTree byq, byev, bydrain;
+    if (D == DSP_JSQ){ mt_init(&byq, N, cnt); mt_init(&byev, N, nxt); }
+    if (D == DSP_LWL) mt_init(&bydrain, N, drain);
+    uint64_t rng = cfg->seed;
+    int *ord = arrival_order(pr, n);
+    int rr = 0;
+
+    for (int k=0;k<n;k++){
+        const Proc *p = &pr[ord[k]];
+        int a = p->arrival, i = 0;
+        switch (D){
+        case DSP_RANDOM: i = rng_below(&rng, N); break;
+        case DSP_RR:     i = rr; rr = rr+1 == N ? 0 : rr+1; break;
+        case DSP_JSQ:
+            for (int e; nxt[e = mt_min(&byev)] < a; ){
+                stp_advance(&node[e], a);
+                cnt[e] = ((long long)(node[e].sz + node[e].busy) << 40) | (cnt[e] & JSQ_STAMP); nxt[e] = stp_next_event(&node[e]);
+                mt_update(&byq, e); mt_update(&byev, e);
+            }
+            i = mt_min(&byq);
+            break;
+        case DSP_POD: {
+            long long best = LLONG_MAX;
+            for (int j=0;j<cfg->pod_d;j++){
+                int c = rng_below(&rng, N);
+                stp_advance(&node[c], a);
+                long long q = node[c].sz + node[c].busy;
+                if (q < best){ best = q; i = c; }
+            }
+            break;
+        }
+        case DSP_LWL:
+            i = mt_min(&bydrain);
+            break;
+        }
+        stp_advance(&node[i], a);
+        stp_arrive(&node[i], (SJob){ .pid=p->pid, .arrival=a, .burst=p->burst, .row=row0 + ord[k] });
+        work[i] += p->burst;
+        if (D == DSP_JSQ){
+            cnt[i] = ((long long)(node[i].sz + node[i].busy) << 40) | (k+1); nxt[i] = stp_next_event(&node[i]);
+            mt_update(&byq, i); mt_update(&byev, i);
+        }
+        if (D == DSP_LWL){ drain[i] = (drain[i] > a ? drain[i] : a) + p->burst; mt_update(&bydrain, i); }
+    }
+    double sr=0, sw=0, st=0; long long done=0, makespan=0;
+    for (int i=0;i<N;i++){
+        stp_drain(&node[i]);
+        sr += acc[i].sr; sw += acc[i].sw; st += acc[i].st; done += acc[i].done;
+        if (node[i].t > makespan) makespan = node[i].t;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("\n%s on %d nodes =>\n", ALG, N);
+    print_avg_sums(ALG, sr, sw, st, done);
+    double *util = (double*)malloc(N*sizeof(double)), *tat = (double*)malloc(N*sizeof(double));
+    if (!util || !tat){ fprintf(stderr,"OOM\n"); exit(1); }
+    long long jmin = LLONG_MAX, jmax = 0;
+    for (int i=0;i<N;i++){
+        util[i] = makespan ? (double)work[i] / makespan : 0;
+        tat[i] = acc[i].done ? acc[i].st / acc[i].done : 0;
+        if (acc[i].done < jmin) jmin = acc[i].done;
+        if (acc[i].done > jmax) jmax = acc[i].done;
+    }
+    if (N <= 16){
+        for (int i=0;i<N;i++)
+            printf("  node %-3d %8lld jobs  util %.3f  mean response %.2f  mean turnaround %.2f  max queue %d\n",
+                   i, acc[i].done, util[i], acc[i].done ? acc[i].sr/acc[i].done : 0, tat[i], node[i].qdepth_max);
+    } else {
+        double *u = (double*)malloc(N*sizeof(double)), *m = (double*)malloc(N*sizeof(double));
+        if (!u || !m){ fprintf(stderr,"OOM\n"); exit(1); }
+        memcpy(u, util, N*sizeof(double)); memcpy(m, tat, N*sizeof(double));
+        qsort(u, N, sizeof(double), cmp_double); qsort(m, N, sizeof(double), cmp_double);
+        printf("  per node: jobs %lld..%lld; util min %.3f p50 %.3f max %.3f; mean turnaround min %.2f p50 %.2f max %.2f\n",
+               jmin, jmax, u[0], u[N/2], u[N-1], m[0], m[N/2], m[N-1]);
+        free(u); free(m);
+    }
+    printf("  Load imbalance (max/mean jobs): %.3f; makespan %lld\n", done ? (double)jmax * N / done : 0.0, makespan);
+    printf("  Cluster: %d jobs over %d nodes in %.3fs\n\n", n, N, ts_diff(&t0, &t1));
+
+    for (int i=0;i<N;i++) stp_free(&node[i]);
+    if (D == DSP_JSQ){ free(byq.t); free(byev.t); }
+    if (D == DSP_LWL) free(bydrain.t);
+    free(node); free(acc); free(cnt); free(nxt); free(drain); free(work); free(util); free(tat); free(ord);
+}
+
+/* ===================== Autoscaling ===================== */
+/* --autoscale: a multi-CPU machine with one shared queue (--node-algo
+   fcfs|sjf, non-preemptive) whose CPU count follows a policy. Everything is
+   event driven. Completions, CPUs becoming ready after --provision-delay and
+   policy re-evaluations sit in one event queue, and arrivals are merged from
+   the sorted cursor. CPU-seconds are integrated between events and booting
+   CPUs are billed. Utilisation is an exponential average with time constant
+   --util-window. Its threshold crossings are solved in closed form and
+   scheduled as evaluation events, so no tick stepping is needed. */
+
+enum { EV_DONE=0, EV_READY=1, EV_EVAL=2 };      /* same-time order */
+typedef struct { long long t; int type; int arg; } Ev;
+typedef struct { Ev *a; int sz, cap; } EvQ;
+
+static bool ev_less(const Ev *x, const Ev *y){ return x->t != y->t ? x->t < y->t : x->type < y->type; }
+static void evq_push(EvQ *q, Ev e){
+    if (q->sz == q->cap){ q->cap = q->cap ? q->cap*2 : 64; q->a = (Ev*)realloc(q->a, q->cap*sizeof(Ev)); if (!q->a){ fprintf(stderr,"OOM\n"); exit(1); } }
+    int i = q->sz++;
+    while (i > 0 && ev_less(&e, &q->a[(i-1)/2])){ q->a[i] = q->a[(i-1)/2]; i = (i-1)/2; }
+    q->a[i] = e;
+}
+static Ev evq_pop(EvQ *q){
+    Ev top = q->a[0], v = q->a[--q->sz]; int i = 0;
+    for (;;){
+        int l = 2*i+1, m = l;
+        if (l >= q->sz) break;
+        if (l+1 < q->sz && ev_less(&q->a[l+1], &q->a[l])) m = l+1;
+        if (!ev_less(&q->a[m], &v)) break;
+        q->a[i] = q->a[m]; i = m;
+    }
+    if (q->sz) q->a[i] = v;
+    return top;
+}
+
+typedef struct {
+    double cpu_secs, mean_wait, p99_wait, mean_tat;
+    long long makespan; int peak, ups, downs;
+} ScaleResult;
+
+static void autoscale_sim(const Proc *pr, const int *ord, int n, int p, const Config *cfg, ScaleResult *r){
+    const int kind = cfg->scale_kind[p]; const double hi = cfg->scale_up[p], lo = cfg->scale_down[p];
+    const int cmin = kind == SC_FIXED ? (int)hi : cfg->cpus_min, cmax = kind == SC_FIXED ? (int)hi : cfg->cpus_max;
+    const double tau = cfg->util_window;
+    long long *wait = (long long*)malloc(n*sizeof(long long));
+    if (!wait){ fprintf(stderr,"OOM\n"); exit(1); }
+    Heap hp; heap_init(&hp, 64);                  /* SJF queue; FCFS waits in ord[qh..k) */
+    bool sjf = cfg->node_algo == ALG_SJF;
+    EvQ eq = {0};
+    long long t = pr[ord[0]].arrival, last_scale = LLONG_MIN/2, eval_at = LLONG_MAX;
+    int active = cmin, pending = 0, busy = 0, k = 0, qh = 0, done = 0;
+    double u = 0, cpu_secs = 0, sw = 0, st = 0;
+    memset(r, 0, sizeof(*r)); r->peak = active;
+
+    while (done < n){
+        long long tn = k < n ? pr[ord[k]].arrival : LLONG_MAX;
+        if (eq.sz && eq.a[0].t < tn) tn = eq.a[0].t;
+        double dt = (double)(tn - t), inst = active ? (double)busy / active : 1.0;
+        cpu_secs += dt * (active + pending);
+        u = inst + (u - inst) * exp(-dt / tau);
+        t = tn;
+        while (eq.sz && eq.a[0].t == t){
+            Ev e = evq_pop(&eq);
+            if (e.type == EV_DONE){ busy--; done++; }
+            else if (e.type == EV_READY){ pending--; active++; if (active > r->peak) r->peak = active; }
+            else eval_at = LLONG_MAX;
+        }
+        while (k < n && pr[ord[k]].arrival <= t){ if (sjf) heap_push_sjf(&hp, pr, ord[k]); k++; }
+        for (;;){                                  /* dispatch onto free CPUs */
+            int qlen = sjf ? hp.sz : k - qh;
+            if (busy >= active || !qlen) break;
+            int i = sjf ? heap_pop_sjf(&hp, pr) : ord[qh++];
+            wait[i] = t - pr[i].arrival;
+            sw += wait[i]; st += wait[i] + pr[i].burst;
+            busy++;
+            evq_push(&eq, (Ev){ t + pr[i].burst, EV_DONE, i });
+        }
+        if (kind == SC_FIXED) continue;
+
+        /* policy */
+        int qlen = sjf ? hp.sz : k - qh, cap = active + pending;
+        bool up, down;
+        if (kind == SC_QUEUE){ up = qlen > hi * cap; down = qlen <= lo * active; }
+        else                 { up = u > hi; down = u < lo; }
+        up = up && cap < cmax;
+        down = down && !up && active > cmin && busy < active && pending == 0;
+        if ((up || down) && t - last_scale < cfg->cooldown){
+            long long at = last_scale + cfg->cooldown;
+            if (at < eval_at){ eval_at = at; evq_push(&eq, (Ev){ at, EV_EVAL, 0 }); }
+        } else if (up){
+            pending++; r->ups++; last_scale = t;
+            evq_push(&eq, (Ev){ t + cfg->provision_delay, EV_READY, 0 });
+        } else if (down){
+            active--; r->downs++; last_scale = t;
+        } else if (kind == SC_UTIL && active){
+            /* when will the average cross a threshold if nothing else happens? */
+            double in = (double)busy / active, thr = in > hi && u <= hi ? hi : in < lo && u >= lo ? lo : -1;
+            if (thr >= 0 && u != in){
+                double x = (thr - in) / (u - in);
+                if (x > 0 && x < 1){
+                    long long at = t + 1 + (long long)(-tau * log(x));
+                    if (at < eval_at){ eval_at = at; evq_push(&eq, (Ev){ at, EV_EVAL, 0 }); }
+                }
+            }
+        }
+    }
+    qsort(wait, n, sizeof(long long), cmp_ll);
+    r->cpu_secs = cpu_secs; r->mean_wait = sw / n; r->mean_tat = st / n;
+    r->p99_wait = (double)wait[(int)((n - 1) * 0.99)]; r->makespan = t;
+    free(wait); free(eq.a); heap_free(&hp);
+}
+
+static void autoscale_run(const Proc *pr, int n, const Config *cfg){
+    int *ord = arrival_order(pr, n);
+    printf("\nAutoscaling (%s queue, CPUs %d..%d, provisioning delay %d, cooldown %d, cost %.4g per CPU-second) =>\n",
+           cfg->node_algo == ALG_SJF ? "SJF" : "FCFS", cfg->cpus_min, cfg->cpus_max, cfg->provision_delay, cfg->cooldown, cfg->cpu_cost);
+    printf("  %-16s %14s %12s %10s %10s %10s %5s %6s %6s\n", "policy", "CPU-seconds", "cost", "mean wait", "p99 wait", "mean TAT", "peak", "ups", "downs");
+    for (int p=0;p<cfg->nscale;p++){
+        ScaleResult r; autoscale_sim(pr, ord, n, p, cfg, &r);
+        printf("  %-16s %14.0f %12.2f %10.2f %10.0f %10.2f %5d %6d %6d\n", cfg->scale_name[p],
+               r.cpu_secs, r.cpu_secs * cfg->cpu_cost, r.mean_wait, r.p99_wait, r.mean_tat, r.peak, r.ups, r.downs);
+    }
+    printf("\n");
+    free(ord);
+}
+
+/* ===================== Periodic tasks ===================== */
+/* --periodic=FILE: one task per line, ID PERIOD WCET OFFSET [DEADLINE]
+   (deadline defaults to the period). Jobs are never materialised. Job k of
+   task i is released at OFFSET + k*PERIOD, so a task needs only
+   released/finished counters and the remaining work of its oldest job.
+   Releases come from a min-tree over next-release times; the ready set is a
+   min-tree over fixed priorities (period for RM, deadline for DM, ties to the
+   lower task index). Memory is O(tasks) whatever the horizon. Observed worst
+   responses are checked against response-time analysis. Synchronous release
+   is the critical instant; since deadlines may exceed periods, the analysis
+   walks every job of the level-i busy window, not just the first. */
+
+typedef struct { int id; long long period, wcet, offset, deadline; } PTask;
+
+static int periodic_load(const char *path, PTask **out){
+    FILE *f = fopen(path, "r");
+    if (!f){ fprintf(stderr,"ERROR: cannot open %s\n", path); exit(1); }
+    PTask *v = NULL; int len = 0, cap = 0; char line[256];
+    while (fgets(line, sizeof(line), f)){
+        PTask t; int k = sscanf(line, "%d %lld %lld %lld %lld", &t.id, &t.period, &t.wcet, &t.offset, &t.deadline);
+        if (k <= 0) continue;
+        if (k < 4){ fprintf(stderr,"ERROR: %s: expected ID PERIOD WCET OFFSET [DEADLINE]\n", path); exit(1); }
+        if (k == 4) t.deadline = t.period;
+        if (t.period <= 0 || t.wcet <= 0 || t.offset < 0 || t.deadline <= 0){ fprintf(stderr,"ERROR: %s: task %d needs positive period/WCET/deadline and offset >= 0\n", path, t.id); exit(1); }
+        if (len == cap){ cap = cap ? cap*2 : 64; v = (PTask*)realloc(v, cap*sizeof(PTask)); if (!v){ fprintf(stderr,"OOM\n"); exit(1); } }
+        v[len++] = t;
+    }
+    fclose(f);
+    if (!len){ fprintf(stderr,"ERROR: %s: no tasks\n", path); exit(1); }
+    *out = v;
+    return len;
+}
+
+static long long gcd_ll(long long a, long long b){ while (b){ long long r = a % b; a = b; b = r; } return a; }
+
+/* Busy-window RTA with priorities taken from key[]: job q of the level-i
+   busy window finishes at w_q = (q+1)C_i + sum_hp ceil(w_q/T_j) C_j and
+   responds in w_q - q T_i; the window closes once w_q <= (q+1) T_i. Returns
+   the worst response, or -1 when one exceeds the deadline or the level-i
+   utilisation is above 1 (the window never closes). */
+static long long rta_bound(const PTask *tk, const long long *key, int m, int i){
+    double U = (double)tk[i].wcet / tk[i].period;
+    for (int j=0;j<m;j++)
+        if (j != i && (key[j] < key[i] || (key[j] == key[i] && j < i))) U += (double)tk[j].wcet / tk[j].period;
+    if (U > 1) return -1;
+    long long worst = 0, w = tk[i].wcet;
+    for (long long q=0;;q++){
+        for (;;){
+            long long next = (q+1) * tk[i].wcet;
+            for (int j=0;j<m;j++)
+                if (j != i && (key[j] < key[i] || (key[j] == key[i] && j < i)))
+                    next += ((w + tk[j].period - 1) / tk[j].period) * tk[j].wcet;
+            if (next - q * tk[i].period > tk[i].deadline) return -1;
+            if (next == w) break;
+            w = next;
+        }
+        if (w - q * tk[i].period > worst) worst = w - q * tk[i].period;
+        if (w <= (q+1) * tk[i].period) return worst;
+        w += tk[i].wcet;   /* job q+1 starts no earlier than here */
+    }
+}
+
+typedef struct { long long released, done, misses, max_resp; double sum_resp; } PStat;
+
+static void periodic_sim(const PTask *tk, int m, bool dm, long long horizon){
+    long long *nrel = (long long*)malloc(m*sizeof(long long)), *rkey = (long long*)malloc(m*sizeof(long long));
+    long long *prio = (long long*)malloc(m*sizeof(long long)), *rem = (long long*)malloc(m*sizeof(long long));
+    PStat *ps = (PStat*)calloc(m, sizeof(PStat));
+    if (!nrel||!rkey||!prio||!rem||!ps){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<m;i++){
+        nrel[i] = tk[i].offset; rkey[i] = LLONG_MAX; rem[i] = 0;
+        prio[i] = dm ? tk[i].deadline : tk[i].period;
+    }
+    MinTree timer, ready; mt_init(&timer, m, nrel); mt_init(&ready, m, rkey);
+    long long t = 0, idle = 0, preempt = 0; int last = -1;
+
+    while (t < horizon){
+        int r = mt_min(&timer);
+        long long next_rel = nrel[r] < horizon ? nrel[r] : horizon;
+        int i = mt_min(&ready);
+        if (rkey[i] == LLONG_MAX){ idle += next_rel - t; t = next_rel; }
+        else {
+            if (last >= 0 && last != i && rem[last] > 0 && rem[last] < tk[last].wcet) preempt++;   /* `last` was cut mid-job */
+            last = i;
+            if (t + rem[i] <= next_rel){           /* the job finishes first */
+                t += rem[i];
+                long long rel = tk[i].offset + ps[i].done * tk[i].period, resp = t - rel;
+                ps[i].done++; ps[i].sum_resp += resp;
+                if (resp > ps[i].max_resp) ps[i].max_resp = resp;
+                if (resp > tk[i].deadline) ps[i].misses++;
+                if (ps[i].released > ps[i].done) rem[i] = tk[i].wcet;
+                else { rem[i] = 0; rkey[i] = LLONG_MAX; mt_update(&ready, i); }
+                continue;
+            }
+            rem[i] -= next_rel - t; t = next_rel;
+        }
+        while (t < horizon && nrel[r = mt_min(&timer)] == t){   /* release everything due now */
+            if (ps[r].released == ps[r].done){ rem[r] = tk[r].wcet; rkey[r] = prio[r]; mt_update(&ready, r); }
+            ps[r].released++;
+            nrel[r] += tk[r].period; mt_update(&timer, r);
+        }
+    }
+
+    long long jobs = 0, done = 0, misses = 0; int bad = 0, unsched = 0;
+    printf("%s =>\n", dm ? "Deadline-monotonic" : "Rate-monotonic");
+    if (m <= 32) printf("  %-6s %10s %8s %9s %12s %10s %10s %8s %8s\n", "task", "period", "wcet", "deadline", "jobs", "mean resp", "max resp", "RTA", "misses");
+    for (int i=0;i<m;i++){
+        long long R = rta_bound(tk, prio, m, i);
+        if (R < 0) unsched++;
+        else if (ps[i].max_resp > R) bad++;
+        jobs += ps[i].released; done += ps[i].done; misses += ps[i].misses;
+        if (m <= 32){
+            char rb[24]; if (R < 0) snprintf(rb, sizeof(rb), "> D"); else snprintf(rb, sizeof(rb), "%lld", R);
+            printf("  %-6d %10lld %8lld %9lld %12lld %10.2f %10lld %8s %8lld\n", tk[i].id, tk[i].period, tk[i].wcet, tk[i].deadline,
+                   ps[i].released, ps[i].done ? ps[i].sum_resp / ps[i].done : 0.0, ps[i].max_resp, rb, ps[i].misses);
+        }
+    }
+    printf("  %lld jobs released, %lld finished by t=%lld, %lld deadline misses, %lld preemptions, idle %lld (%.2f%%)\n",
+           jobs, done, horizon, misses, preempt, idle, horizon ? 100.0 * idle / horizon : 0.0);
+    printf("  RTA cross-check: %d task(s) unschedulable by analysis", unsched);
+    if (bad) printf(", %d task(s) EXCEED their RTA bound\n\n", bad);
+    else     printf(", all observed worst responses within the bounds\n\n");
+    free(timer.t); free(ready.t); free(nrel); free(rkey); free(prio); free(rem); free(ps);
+}
+
+static void periodic_run(const Config *cfg){
+    PTask *tk; int m = periodic_load(cfg->periodic_path, &tk);
+    double U = 0; long long H = 1, omax = 0; bool hp_ok = true;
+    for (int i=0;i<m;i++){
+        U += (double)tk[i].wcet / tk[i].period;
+        if (tk[i].offset > omax) omax = tk[i].offset;
+        if (hp_ok){
+            long long g = gcd_ll(H, tk[i].period);
+            if (H / g > LLONG_MAX / 4 / tk[i].period) hp_ok = false; else H = H / g * tk[i].period;
+        }
+    }
+    long long horizon = cfg->horizon;
+    if (horizon <= 0){
+        if (!hp_ok){ fprintf(stderr,"ERROR: hyperperiod overflows; pass --horizon\n"); exit(1); }
+        horizon = omax + H;
+    }
+    printf("\nPeriodic task set: %d tasks, utilisation %.4f (Liu-Layland bound %.4f), ", m, U, m * (pow(2.0, 1.0/m) - 1));
+    if (hp_ok) printf("hyperperiod %lld", H); else printf("hyperperiod > 2^61");
+    printf(", horizon %lld\n\n", horizon);
+    if (cfg->run_rm) periodic_sim(tk, m, false, horizon);
+    if (cfg->run_dm) periodic_sim(tk, m, true, horizon);
+    free(tk);
+}
+
+/* ===================== Multi-resource packing ===================== */
+/* --machines=M: jobs need (cpu, mem) from the cpu/mem columns for their whole
+   burst and run non-preemptively on one of M machines of --capacity=CPU:MEM.
+   Three policies are compared:
+   - drf: Dominant Resource Fairness across the tenant column. Tenants with
+     queued work sit in a min-tree keyed by dominant share. When the neediest
+     tenant's head job fits nowhere, the tenant is parked in a bucket by the
+     job's CPU demand (a heap by memory). A min-tree over the buckets, keyed
+     by their smallest memory demand, finds the lowest-CPU parked job that
+     the freed machine can hold; a completion wakes only as many tenants as
+     fit together, so selection stays logarithmic in tenants and in the
+     number of distinct CPU demands, whatever the machine capacity.
+   - ff / bf: strict FIFO with first-fit or best-fit placement.
+   Fragmentation is the capacity left free while some job is waiting. */
+
+typedef struct { long long mem; int tenant; } Parked;
+
+static void park_push(Parked **h, int *sz, int *cap, Parked v){
+    if (*sz == *cap){ *cap = *cap ? *cap*2 : 8; *h = (Parked*)realloc(*h, *cap*sizeof(Parked)); if (!*h){ fprintf(stderr,"OOM\n"); exit(1); } }
+    Parked *a = *h; int i = (*sz)++;
+    while (i > 0 && v.mem < a[(i-1)/2].mem){ a[i] = a[(i-1)/2]; i = (i-1)/2; }
+    a[i] = v;
+}
+static Parked park_pop(Parked *a, int *sz){
+    Parked top = a[0], v = a[--*sz]; int i = 0;
+    for (;;){
+        int l = 2*i+1, m = l;
+        if (l >= *sz) break;
+        if (l+1 < *sz && a[l+1].mem < a[l].mem) m = l+1;
+        if (a[m].mem >= v.mem) break;
+        a[i] = a[m]; i = m;
+    }
+    if (*sz) a[i] = v;
+    return top;
+}
+
+/* Machines with a max-tree over free cpu and free mem for first-fit. */
+typedef struct { int m, size; long long *fc, *fm; long long *tc, *tm; } Machines;
+
+static void mach_init(Machines *M, int m, long long cpu, long long mem){
+    M->m = m; M->size = 1; while (M->size < m) M->size <<= 1;
+    M->fc = (long long*)malloc(m*sizeof(long long)); M->fm = (long long*)malloc(m*sizeof(long long));
+    M->tc = (long long*)calloc(2*M->size, sizeof(long long)); M->tm = (long long*)calloc(2*M->size, sizeof(long long));
+    if (!M->fc||!M->fm||!M->tc||!M->tm){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<m;i++){ M->fc[i] = cpu; M->fm[i] = mem; M->tc[M->size+i] = cpu; M->tm[M->size+i] = mem; }
+    for (int p=M->size-1;p>0;p--){
+        M->tc[p] = M->tc[2*p] > M->tc[2*p+1] ? M->tc[2*p] : M->tc[2*p+1];
+        M->tm[p] = M->tm[2*p] > M->tm[2*p+1] ? M->tm[2*p] : M->tm[2*p+1];
+    }
+}
+static void mach_free(Machines *M){ free(M->fc); free(M->fm); free(M->tc); free(M->tm); }
+static void mach_add(Machines *M, int x, long long c, long long mem){
+    M->fc[x] += c; M->fm[x] += mem;
+    int p = M->size + x; M->tc[p] = M->fc[x]; M->tm[p] = M->fm[x];
+    for (p >>= 1; p; p >>= 1){
+        M->tc[p] = M->tc[2*p] > M->tc[2*p+1] ? M->tc[2*p] : M->tc[2*p+1];
+        M->tm[p] = M->tm[2*p] > M->tm[2*p+1] ? M->tm[2*p] : M->tm[2*p+1];
+    }
+}
+static int mach_ff_at(const Machines *M, int p, long long c, long long mem){
+    if (M->tc[p] < c || M->tm[p] < mem) return -1;
+    if (p >= M->size) return p - M->size < M->m ? p - M->size : -1;
+    int r = mach_ff_at(M, 2*p, c, mem);
+    return r >= 0 ? r : mach_ff_at(M, 2*p+1, c, mem);
+}
+static int mach_first_fit(const Machines *M, long long c, long long mem){ return mach_ff_at(M, 1, c, mem); }
+static int mach_best_fit(const Machines *M, long long c, long long mem, long long capc, long long capm){
+    int best = -1; double bl = 0;
+    for (int x=0;x<M->m;x++){
+        if (M->fc[x] < c || M->fm[x] < mem) continue;
+        double left = (double)(M->fc[x] - c) / capc + (capm ? (double)(M->fm[x] - mem) / capm : 0);
+        if (best < 0 || left < bl){ best = x; bl = left; }
+    }
+    return best;
+}
+
+enum { PK_DRF=0, PK_FF=1, PK_BF=2 };
+
+typedef struct { double ucpu, umem, scpu, smem, mean_wait, p99_wait, mean_tat, jain; long long makespan; } PackResult;
+
+static void pack_sim(const Proc *pr, int n, const int *ord, const int *cpu, const int *mem, const int *ten, int nt, int pol, const Config *cfg, PackResult *res){
+    const long long capc = cfg->mach_cpu, capm = cfg->mach_mem, M = cfg->machines;
+    const long long totc = capc * M, totm = capm * M;
+    Machines mc; mach_init(&mc, (int)M, capc, capm);
+    EvQ eq = {0};
+    int *where = (int*)malloc(n*sizeof(int)), *next = (int*)malloc(n*sizeof(int));
+    int *head = (int*)malloc(nt*sizeof(int)), *tail = (int*)malloc(nt*sizeof(int));
+    long long *ac = (long long*)calloc(nt, sizeof(long long)), *am = (long long*)calloc(nt, sizeof(long long));
+    long long *key = (long long*)malloc(nt*sizeof(long long)), *wait = (long long*)malloc(n*sizeof(long long));
+    bool *parked = (bool*)calloc(nt, sizeof(bool));
+    double *tsd = (double*)calloc(nt, sizeof(double)); long long *tcnt = (long long*)calloc(nt, sizeof(long long));
+    /* parking buckets: one per distinct CPU demand, in increasing order */
+    long long *dv = (long long*)malloc(n*sizeof(long long));
+    if (!dv){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++) dv[i] = cpu[i];
+    qsort(dv, n, sizeof(long long), cmp_ll);
+    int nd = 0;
+    for (int i=0;i<n;i++) if (!nd || dv[i] != dv[nd-1]) dv[nd++] = dv[i];
+    Parked **bk = (Parked**)calloc(nd, sizeof(Parked*)); int *bsz = (int*)calloc(nd, sizeof(int)), *bcap = (int*)calloc(nd, sizeof(int));
+    long long *bkey = (long long*)malloc(nd*sizeof(long long));
+    if (!where||!next||!head||!tail||!ac||!am||!key||!wait||!parked||!tsd||!tcnt||!bk||!bsz||!bcap||!bkey){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int u=0;u<nt;u++){ head[u] = tail[u] = -1; key[u] = LLONG_MAX; }
+    for (int b=0;b<nd;b++) bkey[b] = LLONG_MAX;
+    MinTree share, bt;
+    if (pol == PK_DRF){ mt_init(&share, nt, key); mt_init(&bt, nd, bkey); }
+    #define DSHARE(u) ((long long)(1e15 * fmax((double)ac[u] / totc, totm ? (double)am[u] / totm : 0.0)))
+
+    long long t = pr[ord[0]].arrival, uc = 0, um = 0;       /* allocated now */
+    double icpu = 0, imem = 0, scpu = 0, smem = 0, sw = 0, st = 0;
+    int k = 0, qh = 0, done = 0, waiting = 0;
+    while (done < n){
+        long long tn = k < n ? pr[ord[k]].arrival : LLONG_MAX;
+        if (eq.sz && eq.a[0].t < tn) tn = eq.a[0].t;
+        double dt = (double)(tn - t);
+        icpu += dt * uc; imem += dt * um;
+        if (waiting){ scpu += dt * (totc - uc); smem += dt * (totm - um); }
+        t = tn;
+        while (eq.sz && eq.a[0].t == t){
+            int j = evq_pop(&eq).arg, x = where[j], u = ten[j];
+            mach_add(&mc, x, cpu[j], mem[j]); uc -= cpu[j]; um -= mem[j]; done++;
+            if (pol != PK_DRF) continue;
+            ac[u] -= cpu[j]; am[u] -= mem[j];
+            if (head[u] >= 0 && !parked[u]){ key[u] = DSHARE(u); mt_update(&share, u); }
+            long long fc = mc.fc[x], fm = mc.fm[x];     /* wake only what the freed space can hold */
+            for (;;){
+                int lo = 0, hi = nd;                     /* buckets [0, lo) need <= fc cpus */
+                while (lo < hi){ int mid = (lo + hi) / 2; if (dv[mid] <= fc) lo = mid + 1; else hi = mid; }
+                int b = mt_first_le(&bt, 1, 0, bt.size, lo, fm);
+                if (b < 0) break;
+                int v = park_pop(bk[b], &bsz[b]).tenant;
+                bkey[b] = bsz[b] ? bk[b][0].mem : LLONG_MAX; mt_update(&bt, b);
+                fc -= dv[b]; fm -= mem[head[v]];
+                parked[v] = false; key[v] = DSHARE(v); mt_update(&share, v);
+            }
+        }
+        for (; k < n && pr[ord[k]].arrival <= t; k++){
+            int j = ord[k], u = ten[j];
+            waiting++;
+            if (pol != PK_DRF) continue;
+            next[j] = -1;
+            if (head[u] < 0){ head[u] = tail[u] = j; if (!parked[u]){ key[u] = DSHARE(u); mt_update(&share, u); } }
+            else { next[tail[u]] = j; tail[u] = j; }
+        }
+        for (;;){                                   /* launch what fits */
+            int j, x;
+            if (pol == PK_DRF){
+                int u = mt_min(&share);
+                if (key[u] == LLONG_MAX) break;
+                j = head[u];
+                x = mach_first_fit(&mc, cpu[j], mem[j]);
+                if (x < 0){
+                    parked[u] = true; key[u] = LLONG_MAX; mt_update(&share, u);
+                    int lo = 0, hi = nd - 1;
+                    while (lo < hi){ int mid = (lo + hi) / 2; if (dv[mid] < cpu[j]) lo = mid + 1; else hi = mid; }
+                    park_push(&bk[lo], &bsz[lo], &bcap[lo], (Parked){ mem[j], u });
+                    bkey[lo] = bk[lo][0].mem; mt_update(&bt, lo);
+                    continue;
+                }
+                head[u] = next[j]; if (head[u] < 0) tail[u] = -1;
+                ac[u] += cpu[j]; am[u] += mem[j];
+                key[u] = head[u] >= 0 ? DSHARE(u) : LLONG_MAX; mt_update(&share, u);
+            } else {
+                if (qh == k) break;
+                j = ord[qh];
+                x = pol == PK_FF ? mach_first_fit(&mc, cpu[j], mem[j]) : mach_best_fit(&mc, cpu[j], mem[j], capc, capm);
+                if (x < 0) break;                    /* head-of-line waits */
+                qh++;
+            }
+            where[j] = x; mach_add(&mc, x, -cpu[j], -mem[j]); uc += cpu[j]; um += mem[j]; waiting--;
+            wait[j] = t - pr[j].arrival; sw += wait[j]; st += wait[j] + pr[j].burst;
+            tsd[ten[j]] += (double)(wait[j] + pr[j].burst) / pr[j].burst; tcnt[ten[j]]++;
+            evq_push(&eq, (Ev){ t + pr[j].burst, EV_DONE, j });
+        }
+    }
+    #undef DSHARE
+    double s1 = 0, s2 = 0; int users = 0;
+    for (int u=0;u<nt;u++) if (tcnt[u]){ double v = tsd[u] / tcnt[u]; s1 += v; s2 += v*v; users++; }
+    qsort(wait, n, sizeof(long long), cmp_ll);
+    long long span = t - pr[ord[0]].arrival;
+    res->ucpu = span ? icpu / ((double)totc * span) : 0; res->umem = span && totm ? imem / ((double)totm * span) : 0;
+    res->scpu = span ? scpu / ((double)totc * span) : 0; res->smem = span && totm ? smem / ((double)totm * span) : 0;
+    res->mean_wait = sw / n; res->mean_tat = st / n; res->p99_wait = (double)wait[(int)((n-1) * 0.99)];
+    res->jain = s2 > 0 ? s1*s1 / (users * s2) : 1; res->makespan = t;
+    if (pol == PK_DRF){ free(share.t); free(bt.t); }
+    for (int b=0;b<nd;b++) free(bk[b]);
+    free(bk); free(bsz); free(bcap); free(bkey); free(dv);
+    mach_free(&mc); free(eq.a); free(where); free(next); free(head); free(tail); free(ac); free(am); free(key); free(wait);
+    free(parked); free(tsd); free(tcnt);
+}
+
+static void pack_run(const Proc *pr, int n, const Config *cfg){
+    static const char *PK[] = {"drf","first-fit","best-fit"};
+    const JobExt *ext = cfg->ext;
+    int *dflt[NCOLS] = {0};                                  /* absent columns: cpu 1, mem 0, one tenant */
+    const int *col[NCOLS];
+    for (int c=COL_CPU;c<=COL_TENANT;c++){
+        col[c] = ext->v[c];
+        if (col[c]) continue;
+        dflt[c] = (int*)malloc(n*sizeof(int));
+        if (!dflt[c]){ fprintf(stderr,"OOM\n"); exit(1); }
+        for (int i=0;i<n;i++) dflt[c][i] = c == COL_CPU ? 1 : 0;
+        col[c] = dflt[c];
+    }
+    for (int i=0;i<n;i++)
+        if (col[COL_CPU][i] < 1 || col[COL_CPU][i] > cfg->mach_cpu || col[COL_MEM][i] < 0 || col[COL_MEM][i] > cfg->mach_mem){
+            fprintf(stderr,"ERROR: P%d needs cpu 1..%lld and mem 0..%lld\n", pr[i].pid, cfg->mach_cpu, cfg->mach_mem); exit(1);
+        }
+    /* dense tenant numbering */
+    int *ix = (int*)malloc(n*sizeof(int)), *ten = (int*)malloc(n*sizeof(int));
+    if (!ix || !ten){ fprintf(stderr,"OOM\n"); exit(1); }
+    Proc *tp = (Proc*)malloc(n*sizeof(Proc));
+    if (!tp){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){ tp[i].pid = col[COL_TENANT][i]; ix[i] = i; }
+    g_pid_sort = tp; qsort(ix, n, sizeof(int), cmp_pid_index);
+    int nt = 0;
+    for (int r=0;r<n;r++){ if (r && tp[ix[r]].pid != tp[ix[r-1]].pid) nt++; ten[ix[r]] = nt; }
+    nt++;
+    free(tp); free(ix);
+
+    int *ord = arrival_order(pr, n);
+    printf("\nMulti-resource packing (%d machines x %lld cpu / %lld mem, %d tenants) =>\n", cfg->machines, cfg->mach_cpu, cfg->mach_mem, nt);
+    printf("  %-10s %8s %8s %12s %12s %10s %9s %10s %10s %8s\n", "policy", "cpu util", "mem util", "stranded cpu", "stranded mem", "mean wait", "p99 wait", "mean TAT", "makespan", "Jain");
+    for (int p=0;p<3;p++){
+        if (!(cfg->pack_mask & (1<<p))) continue;
+        PackResult r; pack_sim(pr, n, ord, col[COL_CPU], col[COL_MEM], ten, nt, p, cfg, &r);
+        printf("  %-10s %7.2f%% %7.2f%% %11.2f%% %11.2f%% %10.2f %9.0f %10.2f %10lld %8.4f\n", PK[p],
+               100*r.ucpu, 100*r.umem, 100*r.scpu, 100*r.smem, r.mean_wait, r.p99_wait, r.mean_tat, r.makespan, r.jain);
+    }
+    printf("  (stranded = capacity left idle while jobs waited; Jain = fairness of per-tenant mean slowdown)\n\n");
+    free(ord); free(ten);
+    for (int c=0;c<NCOLS;c++) free(dflt[c]);
+}
+
+/* ===================== CPU affinity ===================== */
+/* --smp=K: K CPUs sharing one non-preemptive --node-algo (fcfs|sjf) queue.
+   The affinity column restricts each job to a bitmask of CPUs (bit c = CPU c,
+   0 = any). Waiting jobs sit in one ready structure per distinct mask: a FIFO
+   for FCFS, an SJF heap otherwise. Each CPU keeps an indexed heap over the
+   non-empty classes it may serve, keyed by their head job, so a freed CPU
+   takes the top class and never scans the ready set or empty classes. The
+   same trace is then re-run unconstrained, and the difference is the
+   utilisation lost to placement constraints. */
+
+typedef struct { double util, stranded, mean_wait, p99_wait, mean_tat; long long makespan; int classes; } SmpResult;
+
+static int cmp_uint(const void *a, const void *b){
+    unsigned x = *(const unsigned*)a, y = *(const unsigned*)b;
+    return (x > y) - (x < y);
+}
+
+/* class q leaves or joins the ready heaps of the CPUs in its mask */
+static void smp_detach(IHeap *cq, int K, unsigned cpus, int q){ for (int c=0;c<K;c++) if (cpus >> c & 1u) ih_remove(&cq[c], q); }
+static void smp_attach(IHeap *cq, int K, unsigned cpus, int q){ for (int c=0;c<K;c++) if (cpus >> c & 1u) ih_push(&cq[c], q); }
+
+static void smp_sim(const Proc *pr, int n, const int *ord, const unsigned *mask, int K, bool sjf, SmpResult *res){
+    /* classes = distinct masks */
+    unsigned *cm = (unsigned*)malloc(n*sizeof(unsigned));
+    int *cls = (int*)malloc(n*sizeof(int)), *rank = (int*)malloc(n*sizeof(int)), *next = (int*)malloc(n*sizeof(int));
+    long long *wait = (long long*)malloc(n*sizeof(long long));
+    if (!cm||!cls||!rank||!next||!wait){ fprintf(stderr,"OOM\n"); exit(1); }
+    memcpy(cm, mask, n*sizeof(unsigned));
+    qsort(cm, n, sizeof(unsigned), cmp_uint);
+    int nc = 0;
+    for (int i=0;i<n;i++) if (!i || cm[i] != cm[nc-1]) cm[nc++] = cm[i];
+    for (int i=0;i<n;i++) cls[i] = (int)((unsigned*)bsearch(&mask[i], cm, nc, sizeof(unsigned), cmp_uint) - cm);
+    for (int r=0;r<n;r++) rank[ord[r]] = r;
+
+    int *head = (int*)malloc(nc*sizeof(int)), *tail = (int*)malloc(nc*sizeof(int));
+    Heap *hq = (Heap*)calloc(nc, sizeof(Heap));
+    long long *hkey = (long long*)malloc(nc*sizeof(long long));   /* class head: rank, or burst then rank */
+    if (!head||!tail||!hq||!hkey){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int q=0;q<nc;q++) head[q] = tail[q] = -1;
+    IHeap cq[SMP_MAX];               /* heads are distinct jobs, so keys never tie */
+    for (int c=0;c<K;c++) ih_init(&cq[c], nc, hkey, NULL);
+    #define SMP_HEAD(q) (sjf ? (hq[q].sz ? hq[q].h[0] : -1) : head[q])
+    #define SMP_ATTACH(q) do { int h_ = SMP_HEAD(q); if (h_ >= 0){ hkey[q] = sjf ? (long long)pr[h_].burst * n + rank[h_] : rank[h_]; smp_attach(cq, K, cm[q], q); } } while (0)
+
+    EvQ eq = {0};
+    unsigned idle = K == 32 ? ~0u : (1u << K) - 1;
+    long long t0 = pr[ord[0]].arrival, t = t0;
+    double busy_t = 0, strand = 0, sw = 0, st = 0;
+    int k = 0, done = 0, waiting = 0, busy = 0;
+    while (done < n){
+        long long tn = k < n ? pr[ord[k]].arrival : LLONG_MAX;
+        if (eq.sz && eq.a[0].t < tn) tn = eq.a[0].t;
+        double dt = (double)(tn - t);
+        busy_t += dt * busy;
+        if (waiting) strand += dt * (K - busy);
+        t = tn;
+        unsigned dirty = 0;                             /* CPUs that may find new work */
+        while (eq.sz && eq.a[0].t == t){ int c = evq_pop(&eq).arg; idle |= 1u << c; dirty |= 1u << c; busy--; done++; }
+        for (; k < n && pr[ord[k]].arrival <= t; k++){
+            int j = ord[k], q = cls[j];
+            bool rekey = sjf ? !hq[q].sz || less_sjf(pr, j, hq[q].h[0]) : head[q] < 0;
+            if (rekey) smp_detach(cq, K, cm[q], q);
+            if (sjf) heap_push_sjf(&hq[q], pr, j);
+            else { next[j] = -1; if (head[q] < 0) head[q] = j; else next[tail[q]] = j; tail[q] = j; }
+            if (rekey) SMP_ATTACH(q);
+            dirty |= idle & cm[q]; waiting++;
+        }
+        for (int c=0; dirty && c<K; c++){
+            if (!(dirty >> c & 1u) || !cq[c].sz) continue;
+            int bq = cq[c].h[0], bj = SMP_HEAD(bq);
+            smp_detach(cq, K, cm[bq], bq);
+            if (sjf) heap_pop_sjf(&hq[bq], pr); else head[bq] = next[bj];
+            SMP_ATTACH(bq);
+            idle &= ~(1u << c); busy++; waiting--;
+            wait[bj] = t - pr[bj].arrival; sw += wait[bj]; st += wait[bj] + pr[bj].burst;
+            evq_push(&eq, (Ev){ t + pr[bj].burst, EV_DONE, c });
+        }
+    }
+    qsort(wait, n, sizeof(long long), cmp_ll);
+    double span = (double)(t - t0);
+    res->util = span > 0 ? busy_t / (K * span) : 1; res->stranded = span > 0 ? strand / (K * span) : 0;
+    res->mean_wait = sw / n; res->mean_tat = st / n; res->p99_wait = (double)wait[(int)((n-1) * 0.99)];
+    res->makespan = t; res->classes = nc;
+    #undef SMP_HEAD
+    #undef SMP_ATTACH
+    for (int q=0;q<nc;q++) heap_free(&hq[q]);
+    for (int c=0;c<K;c++) ih_free(&cq[c]);
+    free(hq); free(head); free(tail); free(hkey); free(eq.a);
+    free(cm); free(cls); free(rank); free(next); free(wait);
+}
+
+static void smp_run(const Proc *pr, int n, const Config *cfg){
+    const int K = cfg->smp;
+    const unsigned all = K == 32 ? ~0u : (1u << K) - 1;
+    const int *aff = cfg->ext ? cfg->ext->v[COL_AFFINITY] : NULL;
+    unsigned *mask = (unsigned*)malloc(n*sizeof(unsigned));
+    if (!mask){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){
+        unsigned m = aff ? (unsigned)aff[i] : 0;
+        if (m & ~all){ fprintf(stderr,"ERROR: P%d affinity 0x%x names CPUs beyond %d\n", pr[i].pid, m, K-1); exit(1); }
+        mask[i] = m ? m : all;
+    }
+    int *ord = arrival_order(pr, n);
+    bool sjf = cfg->node_algo == ALG_SJF;
+    SmpResult r[2];
+    smp_sim(pr, n, ord, mask, K, sjf, &r[0]);
+    for (int i=0;i<n;i++) mask[i] = all;
+    smp_sim(pr, n, ord, mask, K, sjf, &r[1]);
+
+    printf("\nCPU affinity (%d CPUs, %s queue, %d affinity classes) =>\n", K, sjf ? "SJF" : "FCFS", r[0].classes);
+    printf("  %-14s %8s %9s %10s %9s %10s %10s\n", "placement", "util", "stranded", "mean wait", "p99 wait", "mean TAT", "makespan");
+    static const char *NM[2] = {"constrained", "unconstrained"};
+    for (int p=0;p<2;p++)
+        printf("  %-14s %7.2f%% %8.2f%% %10.2f %9.0f %10.2f %10lld\n", NM[p],
+               100*r[p].util, 100*r[p].stranded, r[p].mean_wait, r[p].p99_wait, r[p].mean_tat, r[p].makespan);
+    printf("  utilisation lost to constraints: %.2f points (stranded = CPUs idle while a job waited)\n\n", 100*(r[1].util - r[0].util));
+    free(mask); free(ord);
+}
+
+/* ===================== SMT interference ===================== */
+/* --smp=K --smt: CPUs 2c and 2c+1 are hyperthreads of one core. A job of
+   class i whose sibling runs class j progresses at rate 1/S[i][j], where S is
+   the --interference matrix. When a sibling starts or finishes, both jobs'
+   remaining work is settled at the old rate and the completion rescheduled.
+   Stale completions are skipped by a per-CPU version, so rates change only at
+   events. Time runs in micro-ticks so fractional progress stays exact enough.
+   Placements compared:
+   - first:  lowest idle CPU, queue order;
+   - spread: whole idle cores first, queue order;
+   - pair:   like spread, but a CPU whose sibling is busy takes the class head
+             with the lowest combined slowdown against the sibling. */
+
+#define SMT_US 1000000LL
+
+enum { SMT_FIRST=0, SMT_SPREAD=1, SMT_PAIR=2 };
+
+typedef struct { double mean_wait, mean_tat, p99_tat, stretch, core_util; long long makespan; } SmtResult;
+
+typedef struct {
+    int K, C; const double *S;
+    int job[SMP_MAX]; double rem[SMP_MAX], rate[SMP_MAX];
+    long long last[SMP_MAX], fin[SMP_MAX]; unsigned ver[SMP_MAX];
+    EvQ eq;
+} SmtCpus;
+
+static void smt_settle(SmtCpus *m, int c, long long t){
+    m->rem[c] -= (double)(t - m->last[c]) / SMT_US * m->rate[c]; m->last[c] = t;
+    if (m->rem[c] < 0) m->rem[c] = 0;
+}
+static void smt_schedule(SmtCpus *m, int c, long long t, const int *cls){
+    int s = c ^ 1;
+    m->rate[c] = s < m->K && m->job[s] >= 0 ? 1.0 / m->S[cls[m->job[c]] * m->C + cls[m->job[s]]] : 1.0;
+    m->fin[c] = t + (long long)ceil(m->rem[c] / m->rate[c] * SMT_US);
+    m->ver[c] = (m->ver[c] + 1) & 0x3FFFFFF;
+    evq_push(&m->eq, (Ev){ m->fin[c], EV_DONE, c | (int)(m->ver[c] << 5) });
+}
+
+static void smt_sim(const Proc *pr, int n, const int *ord, const int *cls, int pol, bool sjf, const Config *cfg, SmtResult *res){
+    const int K = cfg->smp, C = cfg->smt_classes;
+    SmtCpus m; memset(&m, 0, sizeof(m)); m.K = K; m.C = C; m.S = cfg->smt_slow;
+    for (int c=0;c<K;c++) m.job[c] = -1;
+    int *rank = (int*)malloc(n*sizeof(int)), *next = (int*)malloc(n*sizeof(int));
+    long long *start = (long long*)malloc(n*sizeof(long long)), *tat = (long long*)malloc(n*sizeof(long long));
+    if (!rank||!next||!start||!tat){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int r=0;r<n;r++) rank[ord[r]] = r;
+    int head[SMT_MAX_CLASS], tail[SMT_MAX_CLASS]; Heap hq[SMT_MAX_CLASS];
+    memset(hq, 0, sizeof(hq));
+    for (int q=0;q<C;q++) head[q] = tail[q] = -1;
+
+    long long t0 = pr[ord[0]].arrival * SMT_US, t = t0;
+    double sw = 0, st = 0, stretch = 0, core_busy = 0;
+    int k = 0, done = 0, waiting = 0;
+    while (done < n){
+        long long tn = k < n ? pr[ord[k]].arrival * SMT_US : LLONG_MAX;
+        if (m.eq.sz && m.eq.a[0].t < tn) tn = m.eq.a[0].t;
+        for (int c=0;c<K;c+=2) if (m.job[c] >= 0 || (c+1 < K && m.job[c+1] >= 0)) core_busy += (double)(tn - t);
+        t = tn;
+        while (m.eq.sz && m.eq.a[0].t == t){
+            Ev e = evq_pop(&m.eq); int c = e.arg & 31;
+            if ((unsigned)e.arg >> 5 != m.ver[c] || m.job[c] < 0 || m.fin[c] != t) continue;   /* superseded */
+            int j = m.job[c]; m.job[c] = -1; done++;
+            tat[j] = t - pr[j].arrival * SMT_US; st += tat[j];
+            stretch += (double)(t - start[j]) / SMT_US / pr[j].burst;
+            int s = c ^ 1;
+            if (s < K && m.job[s] >= 0){ smt_settle(&m, s, t); smt_schedule(&m, s, t, cls); }
+        }
+        for (; k < n && pr[ord[k]].arrival * SMT_US <= t; k++){
+            int j = ord[k], q = cls[j];
+            if (sjf) heap_push_sjf(&hq[q], pr, j);
+            else { next[j] = -1; if (head[q] < 0) head[q] = j; else next[tail[q]] = j; tail[q] = j; }
+            waiting++;
+        }
+        while (waiting){                                    /* place onto idle CPUs */
+            int c = -1;
+            for (int x=0;x<K && c<0;x++)
+                if (m.job[x] < 0 && (pol == SMT_FIRST || (x^1) >= K || m.job[x^1] < 0)) c = x;
+            for (int x=0;x<K && c<0;x++) if (m.job[x] < 0) c = x;
+            if (c < 0) break;
+            int s = c ^ 1, sc = s < K && m.job[s] >= 0 ? cls[m.job[s]] : -1;
+            int bq = -1, bj = -1; double bcost = 0;
+            for (int q=0;q<C;q++){
+                int j = sjf ? (hq[q].sz ? hq[q].h[0] : -1) : head[q];
+                if (j < 0) continue;
+                double cost = pol == SMT_PAIR && sc >= 0 ? m.S[q*C + sc] + m.S[sc*C + q] : 0;
+                bool better = bj < 0 || cost < bcost || (cost == bcost && (sjf ? less_sjf(pr, j, bj) : rank[j] < rank[bj]));
+                if (better){ bq = q; bj = j; bcost = cost; }
+            }
+            if (sjf) heap_pop_sjf(&hq[bq], pr); else head[bq] = next[bj];
+            waiting--;
+            start[bj] = t; sw += (double)(t - pr[bj].arrival * SMT_US);
+            m.job[c] = bj; m.rem[c] = pr[bj].burst; m.last[c] = t;
+            if (sc >= 0){ smt_settle(&m, s, t); smt_schedule(&m, s, t, cls); }
+            smt_schedule(&m, c, t, cls);
+        }
+    }
+    qsort(tat, n, sizeof(long long), cmp_ll);
+    double span = (double)(t - t0);
+    res->mean_wait = sw / n / SMT_US; res->mean_tat = st / n / SMT_US;
+    res->p99_tat = (double)tat[(int)((n-1) * 0.99)] / SMT_US; res->stretch = stretch / n;
+    res->core_util = span > 0 ? core_busy / (((K + 1) / 2) * span) : 1; res->makespan = (t + SMT_US - 1) / SMT_US;
+    for (int q=0;q<C;q++) heap_free(&hq[q]);
+    free(m.eq.a); free(rank); free(next); free(start); free(tat);
+}
+
+static void smt_run(const Proc *pr, int n, const Config *cfg){
+    const int *cc = cfg->ext ? cfg->ext->v[COL_CLASS] : NULL;
+    int *cls = (int*)calloc(n, sizeof(int));
+    if (!cls){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n && cc;i++){
+        if (cc[i] < 0 || cc[i] >= cfg->smt_classes){ fprintf(stderr,"ERROR: P%d class %d outside the %dx%d interference matrix\n", pr[i].pid, cc[i], cfg->smt_classes, cfg->smt_classes); exit(1); }
+        cls[i] = cc[i];
+    }
+    int *ord = arrival_order(pr, n);
+    bool sjf = cfg->node_algo == ALG_SJF;
+    static const char *NM[3] = {"first", "spread", "pair"};
+    printf("\nSMT interference (%d CPUs on %d cores, %s queue, %d job classes) =>\n", cfg->smp, (cfg->smp + 1) / 2, sjf ? "SJF" : "FCFS", cfg->smt_classes);
+    printf("  %-10s %10s %10s %10s %9s %10s %10s\n", "placement", "mean wait", "mean TAT", "p99 TAT", "stretch", "core util", "makespan");
+    for (int p=0;p<3;p++){
+        SmtResult r; smt_sim(pr, n, ord, cls, p, sjf, cfg, &r);
+        printf("  %-10s %10.2f %10.2f %10.1f %9.3f %9.2f%% %10lld\n", NM[p], r.mean_wait, r.mean_tat, r.p99_tat, r.stretch, 100*r.core_util, r.makespan);
+    }
+    printf("  (stretch = run time / burst, the mean slowdown from co-runners)\n\n");
+    free(cls); free(ord);
+}
+
+/* ===================== Gang scheduling ===================== */
+/* --gang=P: jobs needing k CPUs (cpu column) are gangs whose k threads run
+   together. The Ousterhout matrix has --gang-rows time slots over P CPU
+   columns. Queued gangs are admitted FCFS into the first row with k free
+   columns; that row is found through the Machines max-tree, one "machine"
+   per row. Each --quantum the next non-empty row runs. With alternative
+   scheduling, gangs from other rows also run when all their columns are idle
+   in the active row. A slot ends early once all its gangs finish, and a lone
+   row runs until its next completion or arrival instead of slot by slot.
+   Fragmentation is the CPU time left idle in slots while gangs were
+   resident. */
+
+typedef struct { double util, frag, mean_tat, mean_sd, p99_sd; long long makespan, slots; } GangResult;
+
+static void gang_sim(const Proc *pr, int n, const int *ord, const int *kk, bool alt, const Config *cfg, GangResult *res){
+    const int P = cfg->gang, R = cfg->gang_rows, W = (P + 63) / 64;
+    const long long Q = cfg->quantum;
+    Machines rows; mach_init(&rows, R, P, 0);
+    uint64_t *occ = (uint64_t*)calloc((size_t)R*W, sizeof(uint64_t)), *busy = (uint64_t*)malloc(W*sizeof(uint64_t));
+    int *rj = (int*)malloc((size_t)R*P*sizeof(int)), *rn = (int*)calloc(R, sizeof(int));
+    int **cols = (int**)calloc(n, sizeof(int*));
+    long long *rem = (long long*)malloc(n*sizeof(long long));
+    double *sd = (double*)malloc(n*sizeof(double));
+    bool *run = (bool*)calloc(n, sizeof(bool));
+    if (!occ||!busy||!rj||!rn||!cols||!rem||!sd||!run){ fprintf(stderr,"OOM\n"); exit(1); }
+
+    long long t = pr[ord[0]].arrival;
+    double used = 0, hole = 0, st = 0;
+    int k = 0, qh = 0, done = 0, resident = 0, nonempty = 0, rot = R - 1;
+    res->slots = 0;
+    while (done < n){
+        for (; k < n && pr[ord[k]].arrival <= t; k++) rem[ord[k]] = pr[ord[k]].burst;
+        for (; qh < k; qh++){                       /* FCFS admission into the matrix */
+            int j = ord[qh], r = mach_first_fit(&rows, kk[j], 0);
+            if (r < 0) break;
+            if (rows.fc[r] == P) nonempty++;
+            mach_add(&rows, r, -kk[j], 0);
+            uint64_t *o = occ + (size_t)r*W;
+            cols[j] = (int*)malloc(kk[j]*sizeof(int));
+            if (!cols[j]){ fprintf(stderr,"OOM\n"); exit(1); }
+            for (int w=0, got=0; got < kk[j]; w++){
+                if (o[w] == ~0ull) continue;
+                for (int b=0; b<64 && got < kk[j] && w*64+b < P; b++)
+                    if (!(o[w] >> b & 1)){ o[w] |= 1ull << b; cols[j][got++] = w*64+b; }
+            }
+            rj[(size_t)r*P + rn[r]++] = j; resident++;
+        }
+        if (!resident){ t = pr[ord[k]].arrival; continue; }
+
+        do rot = (rot + 1) % R; while (!rn[rot]);       /* next non-empty row */
+        long long L = Q, nextarr = k < n ? pr[ord[k]].arrival : LLONG_MAX;
+        if (nonempty == 1){                              /* a lone row rotates onto itself */
+            long long m = nextarr - t;
+            for (int x=0;x<rn[rot];x++){ int j = rj[(size_t)rot*P + x]; if (rem[j] < m) m = rem[j]; }
+            if (m / Q > 1) L = m / Q * Q;
+        }
+        memcpy(busy, occ + (size_t)rot*W, W*sizeof(uint64_t));
+        long long longest = 0;                           /* the slot ends early once all its gangs finish */
+        for (int x=0;x<rn[rot];x++){ int j = rj[(size_t)rot*P + x]; run[j] = true; if (rem[j] > longest) longest = rem[j]; }
+        if (alt)
+            for (int d=1; d<R; d++){
+                int r = (rot + d) % R;
+                for (int x=0;x<rn[r];x++){
+                    int j = rj[(size_t)r*P + x], y = 0;
+                    for (; y<kk[j]; y++) if (busy[cols[j][y] >> 6] >> (cols[j][y] & 63) & 1) break;
+                    if (y < kk[j]) continue;
+                    for (y=0; y<kk[j]; y++) busy[cols[j][y] >> 6] |= 1ull << (cols[j][y] & 63);
+                    run[j] = true; if (rem[j] > longest) longest = rem[j];
+                }
+            }
+        if (longest < L) L = longest;
+        /* run the slot, then retire finished gangs */
+        double slot_used = 0;
+        for (int r=0;r<R;r++)
+            for (int x=0;x<rn[r];){
+                int j = rj[(size_t)r*P + x];
+                if (!run[j]){ x++; continue; }
+                run[j] = false;
+                long long d = rem[j] < L ? rem[j] : L;
+                rem[j] -= d; slot_used += (double)d * kk[j];
+                if (rem[j]){ x++; continue; }
+                long long tat = t + d - pr[j].arrival;
+                st += tat; sd[done++] = (double)tat / pr[j].burst;
+                uint64_t *o = occ + (size_t)r*W;
+                for (int y=0;y<kk[j];y++) o[cols[j][y] >> 6] &= ~(1ull << (cols[j][y] & 63));
+                free(cols[j]); cols[j] = NULL;
+                mach_add(&rows, r, kk[j], 0); if (rows.fc[r] == P) nonempty--;
+                rj[(size_t)r*P + x] = rj[(size_t)r*P + --rn[r]]; resident--;
+                if (t + d > res->makespan) res->makespan = t + d;
+            }
+        used += slot_used; hole += (double)P * L - slot_used;
+        t += L; res->slots += L > Q ? L / Q : 1;
+    }
+    qsort(sd, n, sizeof(double), cmp_double);
+    double s = 0; for (int i=0;i<n;i++) s += sd[i];
+    double span = (double)(res->makespan - pr[ord[0]].arrival);
+    res->util = span > 0 ? used / ((double)P * span) : 1; res->frag = used + hole > 0 ? hole / (used + hole) : 0;
+    res->mean_tat = st / n; res->mean_sd = s / n; res->p99_sd = sd[(int)((n-1) * 0.99)];
+    mach_free(&rows); free(occ); free(busy); free(rj); free(rn); free(cols); free(rem); free(sd); free(run);
+}
+
+static void gang_run(const Proc *pr, int n, const Config *cfg){
+    const int *cc = cfg->ext ? cfg->ext->v[COL_CPU] : NULL;
+    int *kk = (int*)malloc(n*sizeof(int));
+    if (!kk){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++){
+        kk[i] = cc ? cc[i] : 1;
+        if (kk[i] < 1 || kk[i] > cfg->gang){ fprintf(stderr,"ERROR: P%d gang size %d outside 1..%d\n", pr[i].pid, kk[i], cfg->gang); exit(1); }
+    }
+    int *ord = arrival_order(pr, n);
+    printf("\nGang scheduling (%d CPUs, %d matrix rows, quantum %d) =>\n", cfg->gang, cfg->gang_rows, cfg->quantum);
+    printf("  %-12s %8s %8s %10s %10s %9s %10s %10s\n", "scheme", "util", "frag", "mean TAT", "slowdown", "p99 sd", "makespan", "slots");
+    for (int a=0;a<2;a++){
+        GangResult r; memset(&r, 0, sizeof(r));
+        gang_sim(pr, n, ord, kk, a == 1, cfg, &r);
+        printf("  %-12s %7.2f%% %7.2f%% %10.2f %10.3f %9.2f %10lld %10lld\n", a ? "alternative" : "gang",
+               100*r.util, 100*r.frag, r.mean_tat, r.mean_sd, r.p99_sd, r.makespan, r.slots);
+    }
+    printf("  (frag = idle CPU time in slots with resident gangs; slowdown = TAT / burst)\n\n");
+    free(kk); free(ord);
+}
+
+/* ===================== Moldable and malleable jobs ===================== */
+/* --mold=P: jobs of serial work `burst` run on p of P CPUs at speedup s(p).
+   s comes from Amdahl's law, with --amdahl or a per-job serial column in
+   percent, or from a shared --speedup table. Three allocators are compared:
+   - fixed:     every job takes --fixed-width CPUs, FCFS;
+   - moldable:  width chosen once at start, an equal share of P among the
+                waiting jobs, trimmed while efficiency s(p)/p < 1/2;
+   - malleable: equipartition of P over the running jobs, recomputed at every
+                arrival and completion.
+   Remaining work changes only at events. Between events each running job
+   drains at its constant rate s(p), so time is continuous (double). */
+
+enum { MOLD_FIXED=0, MOLD_MOLDABLE=1, MOLD_MALLEABLE=2 };
+
+typedef struct { double makespan, mean_resp, mean_tat, mean_width, eff; } MoldResult;
+
+static double mold_speedup(const Config *cfg, const int *serial, int j, int p){
+    if (cfg->nspeedup) return cfg->speedup[(p < cfg->nspeedup ? p : cfg->nspeedup) - 1];
+    double f = serial ? serial[j] / 100.0 : cfg->amdahl;
+    return 1.0 / (f + (1 - f) / p);
+}
+
+static void mold_sim(const Proc *pr, int n, const int *ord, const int *serial, int pol, const Config *cfg, MoldResult *res){
+    const int P = cfg->mold;
+    int *runj = (int*)malloc(P*sizeof(int)), *width = (int*)malloc(n*sizeof(int));
+    double *rem = (double*)malloc(n*sizeof(double)), *rate = (double*)malloc(n*sizeof(double));
+    if (!runj||!width||!rem||!rate){ fprintf(stderr,"OOM\n"); exit(1); }
+    double t = pr[ord[0]].arrival, sr = 0, st = 0, cpu_time = 0, work = 0;
+    int nrun = 0, free_cpus = P, k = 0, qh = 0, done = 0;
+    while (done < n){
+        /* next event: an arrival or the earliest completion */
+        double tn = k < n ? (double)pr[ord[k]].arrival : INFINITY;
+        for (int x=0;x<nrun;x++){ int j = runj[x]; double f = t + rem[j] / rate[j]; if (f < tn) tn = f; }
+        double dt = tn - t;
+        bool changed = false;
+        for (int x=0;x<nrun;){
+            int j = runj[x];
+            bool fin = t + rem[j] / rate[j] <= tn;        /* same test as the event pick, no drift */
+            rem[j] -= dt * rate[j]; cpu_time += dt * width[j];
+            if (!fin){ x++; continue; }
+            st += tn - pr[j].arrival; done++; free_cpus += width[j]; changed = true;
+            runj[x] = runj[--nrun];
+        }
+        t = tn;
+        for (; k < n && pr[ord[k]].arrival <= t; k++) rem[ord[k]] = pr[ord[k]].burst;
+        while (qh < k){                                /* FCFS starts */
+            int j = ord[qh], p;
+            if (pol == MOLD_MALLEABLE){ if (nrun == P) break; p = 0; }   /* sized below */
+            else {
+                if (pol == MOLD_FIXED) p = cfg->fixed_width;
+                else {
+                    p = P / (k - qh); if (p < 1) p = 1;
+                    if (p > free_cpus) p = free_cpus;
+                    while (p > 1 && mold_speedup(cfg, serial, j, p) < 0.5 * p) p--;
+                }
+                if (!free_cpus || p > free_cpus) break;
+                rate[j] = mold_speedup(cfg, serial, j, p);
+            }
+            qh++; free_cpus -= p; width[j] = p; runj[nrun++] = j;
+            sr += t - pr[j].arrival; changed = true;
+        }
+        if (pol == MOLD_MALLEABLE && changed && nrun){
+            /* equipartition over the running jobs */
+            int base = P / nrun, extra = P % nrun;
+            for (int x=0;x<nrun;x++){
+                int j = runj[x], p = base + (x < extra);
+                width[j] = p; rate[j] = mold_speedup(cfg, serial, j, p);
+            }
+        }
+    }
+    for (int i=0;i<n;i++) work += pr[i].burst;
+    res->makespan = t; res->mean_resp = sr / n; res->mean_tat = st / n;
+    res->mean_width = st > sr ? cpu_time / (st - sr) : 0; res->eff = cpu_time > 0 ? work / cpu_time : 1;
+    free(runj); free(width); free(rem); free(rate);
+}
+
+static void mold_run(const Proc *pr, int n, const Config *cfg){
+    const int *serial = cfg->ext ? cfg->ext->v[COL_SERIAL] : NULL;
+    for (int i=0;i<n && serial;i++)
+        if (serial[i] < 0 || serial[i] > 100){ fprintf(stderr,"ERROR: P%d serial fraction %d%% outside 0..100\n", pr[i].pid, serial[i]); exit(1); }
+    int *ord = arrival_order(pr, n);
+    static const char *NM[3] = {"fixed", "moldable", "malleable"};
+    printf("\nParallel jobs (%d CPUs, ", cfg->mold);
+    if (cfg->nspeedup) printf("speedup table of %d widths", cfg->nspeedup);
+    else if (serial) printf("Amdahl, per-job serial fraction");
+    else printf("Amdahl, serial fraction %.3g", cfg->amdahl);
+    printf(", fixed width %d) =>\n", cfg->fixed_width);
+    printf("  %-10s %12s %10s %12s %10s %10s\n", "allocation", "makespan", "response", "turnaround", "width", "efficiency");
+    for (int p=0;p<3;p++){
+        MoldResult r; mold_sim(pr, n, ord, serial, p, cfg, &r);
+        printf("  %-10s %12.2f %10.2f %12.2f %10.2f %9.2f%%\n", NM[p], r.makespan, r.mean_resp, r.mean_tat, r.mean_width, 100*r.eff);
+    }
+    printf("  (width = mean CPUs held while running; efficiency = serial work / CPU time held)\n\n");
+    free(ord);
+}
+
+/* ===================== Real execution ===================== */
+/* --execute=ALG replays the schedule of one engine on real hardware. Every
+   process gets a worker thread pinned to --exec-cpu, and a simulated tick
+   lasts --tick-us. Only the worker owning the current segment runs; it
+   busy-loops for the segment's length and then hands the CPU to the next
+   segment's owner by a futex wake, and parks on its own futex word. After an
+   idle gap the next segment waits for its wall-clock start (sleep, then spin
+   the tail). Late starts push everything after them, so measured response
+   and turnaround include the real switch cost, which is also reported per
+   handoff (previous end -> next start). */
+
+#define EXEC_MAX_THREADS 4096
+
+typedef struct {
+    const Seg *seg; int nseg;
+    const int *owner;                  /* job index per segment, -1 = idle */
+    long long tick_ns, base;
+    _Atomic uint32_t *go;              /* per job: 1 = your turn */
+    atomic_int cursor;                 /* segment being run, nseg = finished */
+    _Atomic uint32_t finished;         /* the controller sleeps on this */
+    long long *sa, *se;                /* actual ns per segment, relative to base */
+    int cpu;
+} Exec;
+
+typedef struct { Exec *x; int id; } ExecArg;
+
+static long long now_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+static void futex_wait_u32(_Atomic uint32_t *w, uint32_t v){ syscall(SYS_futex, (uint32_t*)w, FUTEX_WAIT_PRIVATE, v, NULL, NULL, 0); }
+static void futex_wake_u32(_Atomic uint32_t *w){ syscall(SYS_futex, (uint32_t*)w, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0); }
+
+static void exec_until(long long at){           /* sleep most of the way, spin the rest */
+    long long left = at - now_ns();
+    if (left > 200000){
+        struct timespec ts = { (at - 100000) / 1000000000LL, (at - 100000) % 1000000000LL };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    }
+    while (now_ns() < at) ;
+}
+
+static void *exec_worker(void *arg){
+    ExecArg *a = (ExecArg*)arg; Exec *x = a->x; const int me = a->id;
+    cpu_set_t cs; CPU_ZERO(&cs); CPU_SET(x->cpu, &cs);
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(cs), &cs);
+    if (err){ fprintf(stderr,"ERROR: cannot pin worker to CPU %d: %s\n", x->cpu, strerror(err)); exit(1); }
+    for (;;){
+        while (!atomic_load(&x->go[me])) futex_wait_u32(&x->go[me], 0);
+        atomic_store(&x->go[me], 0);
+        int k = atomic_load(&x->cursor);
+        if (k >= x->nseg) return NULL;
+        const Seg *s = &x->seg[k];
+        if (k == 0 || x->owner[k-1] < 0) exec_until(x->base + s->start * x->tick_ns);
+        long long t = now_ns(), stop = t + (long long)(s->end - s->start) * x->tick_ns;
+        x->sa[k] = t - x->base;
+        while ((t = now_ns()) < stop) ;             /* the job's work */
+        x->se[k] = t - x->base;
+        int nk = k + 1;
+        while (nk < x->nseg && x->owner[nk] < 0) nk++;
+        atomic_store(&x->cursor, nk);
+        if (nk == x->nseg){ atomic_store(&x->finished, 1); futex_wake_u32(&x->finished); return NULL; }
+        int j = x->owner[nk];
+        atomic_store(&x->go[j], 1); futex_wake_u32(&x->go[j]);
+    }
+}
+
+static void exec_run(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    if (n > EXEC_MAX_THREADS){ fprintf(stderr,"ERROR: --execute runs one thread per process, at most %d\n", EXEC_MAX_THREADS); exit(1); }
+    cpu_set_t mine;
+    if (sched_getaffinity(0, sizeof(mine), &mine) != 0 || !CPU_ISSET(cfg->exec_cpu, &mine)){
+        fprintf(stderr,"ERROR: --exec-cpu=%d is not in this process's CPU set\n", cfg->exec_cpu); exit(1);
+    }
+    Policy p; policy_set(&p, cfg->exec_alg, cfg->quantum);
+    Config q = quiet_config(cfg);
+    SegVec sv = {0};
+    int *st = (int*)malloc(n*sizeof(int)), *en = (int*)malloc(n*sizeof(int));
+    if (!st || !en){ fprintf(stderr,"OOM\n"); exit(1); }
+    SimOut so; simout_init(&so, st, en, NULL, &sv);
+    sim_policy(&p, pr, n, &q, &so);
+
+    int *ix = pid_index(pr, n), *owner = (int*)malloc(sv.len*sizeof(int));
+    long long *sa = (long long*)malloc(sv.len*sizeof(long long)), *se = (long long*)malloc(sv.len*sizeof(long long));
+    _Atomic uint32_t *go = (_Atomic uint32_t*)calloc(n, sizeof(*go));
+    pthread_t *th = (pthread_t*)malloc(n*sizeof(pthread_t)); ExecArg *args = (ExecArg*)malloc(n*sizeof(ExecArg));
+    if (!owner||!sa||!se||!go||!th||!args){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int k=0;k<sv.len;k++) owner[k] = sv.a[k].pid < 0 ? -1 : pid_lookup(pr, ix, n, sv.a[k].pid);
+    free(ix);
+
+    Exec x = { .seg = sv.a, .nseg = sv.len, .owner = owner, .tick_ns = cfg->tick_us * 1000LL, .go = go, .sa = sa, .se = se, .cpu = cfg->exec_cpu };
+    int first = 0;
+    while (first < sv.len && owner[first] < 0) first++;
+    atomic_init(&x.cursor, first); atomic_init(&x.finished, 0);
+    pthread_attr_t at; pthread_attr_init(&at); pthread_attr_setstacksize(&at, 64 * 1024);
+    printf("\nReal execution of %s on CPU %d, %d threads, tick %d us (about %.2f s) =>\n",
+           p.name, cfg->exec_cpu, n, cfg->tick_us, (double)so.stop * cfg->tick_us / 1e6);
+    fflush(stdout);
+    for (int i=0;i<n;i++){
+        args[i] = (ExecArg){ &x, i };
+        if (pthread_create(&th[i], &at, exec_worker, &args[i])){ fprintf(stderr,"ERROR: cannot start worker %d\n", i); exit(1); }
+    }
+    pthread_attr_destroy(&at);
+    x.base = now_ns() + 5000000;                    /* let the workers park first */
+    if (first < sv.len){ atomic_store(&go[owner[first]], 1); futex_wake_u32(&go[owner[first]]); }
+    else atomic_store(&x.finished, 1);
+    while (!atomic_load(&x.finished)) futex_wait_u32(&x.finished, 0);
+    for (int i=0;i<n;i++){ atomic_store(&go[i], 1); futex_wake_u32(&go[i]); }
+    for (int i=0;i<n;i++) pthread_join(th[i], NULL);
+
+    /* measured start/end per job, in ticks */
+    double *ms = (double*)malloc(n*sizeof(double)), *me = (double*)malloc(n*sizeof(double));
+    int *rs = (int*)malloc(n*sizeof(int)), *re = (int*)malloc(n*sizeof(int));
+    long long *ho = (long long*)malloc((sv.len ? sv.len : 1)*sizeof(long long));
+    if (!ms||!me||!rs||!re||!ho){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (int i=0;i<n;i++) ms[i] = -1;
+    int nh = 0, prev = -1;
+    for (int k=0;k<sv.len;k++){
+        int j = owner[k];
+        if (j < 0){ prev = -1; continue; }
+        double a = (double)sa[k] / x.tick_ns, b = (double)se[k] / x.tick_ns;
+        if (ms[j] < 0) ms[j] = a;
+        me[j] = b;
+        if (prev >= 0) ho[nh++] = sa[k] - se[prev];
+        prev = k;
+    }
+    double sr[2] = {0}, stt[2] = {0}, mk = 0;
+    for (int i=0;i<n;i++){
+        sr[0] += st[i] - pr[i].arrival; stt[0] += en[i] - pr[i].arrival;
+        sr[1] += ms[i] - pr[i].arrival; stt[1] += me[i] - pr[i].arrival;
+        if (me[i] > mk) mk = me[i];
+        rs[i] = (int)llround(ms[i]); re[i] = (int)llround(me[i]);
+    }
+    qsort(ho, nh, sizeof(long long), cmp_ll);
+    double hs = 0; for (int h=0;h<nh;h++) hs += ho[h];
+    printf("  %-12s %12s %12s\n", "", "simulated", "measured");
+    printf("  %-12s %12.2f %12.2f\n", "Response", sr[0] / n, sr[1] / n);
+    printf("  %-12s %12.2f %12.2f\n", "Turnaround", stt[0] / n, stt[1] / n);
+    printf("  %-12s %12d %12.2f\n", "Makespan", so.stop, mk);
+    if (nh) printf("  Handoffs: %d, dispatch overhead mean %.1f us, p50 %.1f, p99 %.1f, max %.1f\n\n",
+                   nh, hs / nh / 1e3, ho[nh/2] / 1e3, ho[(int)((nh-1) * 0.99)] / 1e3, ho[nh-1] / 1e3);
+    else printf("  Handoffs: none\n\n");
+    char alg[64]; snprintf(alg, sizeof(alg), "Exec-%s", p.name);
+    csv_dump_algo(csv, alg, pr, n, rs, re);
+    seg_free(&sv); free(st); free(en); free(owner); free(sa); free(se); free((void*)go); free(th); free(args);
+    free(ms); free(me); free(rs); free(re); free(ho);
+}
+
+/* ===================== Kernel calibration ===================== */
+/* --calibrate=other,rr,fifo runs the workload under the Linux scheduler.
+   Each process is forked ahead, confined to --calib-cpus and switched to the
+   policy, then released at its arrival offset (ticks of --tick-us) to burn
+   `burst` ticks of its own CPU time. Children write their first-run and finish times to a
+   shared page, and the results go through the usual averages and CSV path
+   as Kernel-<POLICY> rows. RT policies need privileges and are skipped with
+   a note otherwise. The parent moves off the measured CPUs when it can and
+   takes a higher RT priority, so it releases jobs on time. */
+
+#define CALIB_MAX_PROCS 4096
+
+static bool parse_cpu_list(const char *v, cpu_set_t *cs){
+    CPU_ZERO(cs);
+    while (*v){
+        char *e; long a = strtol(v, &e, 10), b = a;
+        if (e == v) return false;
+        if (*e == '-'){ v = e + 1; b = strtol(v, &e, 10); if (e == v) return false; }
+        if (a < 0 || b < a || b >= CPU_SETSIZE) return false;
+        for (long c=a;c<=b;c++) CPU_SET(c, cs);
+        v = e; if (*v == ',') v++; else if (*v) return false;
+    }
+    return CPU_COUNT(cs) > 0;
+}
+/* "0-3,6" form of a CPU set */
+static void format_cpu_list(const cpu_set_t *cs, char *buf, size_t len){
+    size_t k = 0; buf[0] = '\0';
+    for (int c=0;c<CPU_SETSIZE && k < len;c++){
+        if (!CPU_ISSET(c, cs)) continue;
+        int e = c; while (e+1 < CPU_SETSIZE && CPU_ISSET(e+1, cs)) e++;
+        k += snprintf(buf + k, len - k, e > c ? "%s%d-%d" : "%s%d", k ? "," : "", c, e);
+        c = e;
+    }
+}
+
+static long long cpu_ns(void){
+    struct timespec ts; clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/* Children are forked up front and park on a futex word in the shared page.
+   A woken SCHED_FIFO/RR task goes to the tail of its priority list, which a
+   priority change after fork would not guarantee. */
+typedef struct { long long t[2]; _Atomic uint32_t gate; } CalibSlot;
+
+/* one policy; false (with errno set) if the kernel refused it */
+static bool calib_policy(const Proc *pr, int n, const int *ord, int policy, const cpu_set_t *cs, long long tick_ns, int *start, int *end){
+    size_t bytes = 2 * sizeof(long long) + n * sizeof(CalibSlot);
+    void *page = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED){ fprintf(stderr,"ERROR: cannot map shared results\n"); exit(1); }
+    atomic_int *ready = (atomic_int*)page, *failed = (atomic_int*)((char*)page + sizeof(long long));   /* failed: errno of a child */
+    CalibSlot *sl = (CalibSlot*)((char*)page + 2 * sizeof(long long));
+    struct sched_param sp = { .sched_priority = policy == SCHED_OTHER ? 0 : 1 };
+    struct sched_param pp = { .sched_priority = 2 }, old_pp; int old_pol = sched_getscheduler(0);
+    sched_getparam(0, &old_pp);
+    if (policy != SCHED_OTHER && sched_setscheduler(0, policy, &sp) != 0){ munmap(page, bytes); return false; }   /* probe */
+    if (policy != SCHED_OTHER) sched_setscheduler(0, old_pol, &old_pp);
+    pid_t *kids = (pid_t*)malloc(n*sizeof(pid_t));
+    if (!kids){ fprintf(stderr,"OOM\n"); exit(1); }
+    fflush(NULL);
+    for (int i=0;i<n;i++){
+        pid_t c = fork();
+        if (c < 0){ fprintf(stderr,"ERROR: fork failed: %s\n", strerror(errno)); exit(1); }
+        if (c == 0){
+            if (sched_setaffinity(0, sizeof(*cs), cs) != 0 || sched_setscheduler(0, policy, &sp) != 0){
+                atomic_store(failed, errno); atomic_fetch_add(ready, 1); _exit(1);
+            }
+            atomic_fetch_add(ready, 1);
+            while (!atomic_load(&sl[i].gate)) syscall(SYS_futex, (uint32_t*)&sl[i].gate, FUTEX_WAIT, 0, NULL, NULL, 0);
+            long long base = sl[i].t[0];
+            sl[i].t[0] = now_ns() - base;
+            long long stop = cpu_ns() + pr[i].burst * tick_ns;
+            while (cpu_ns() < stop) ;
+            sl[i].t[1] = now_ns() - base;
+            _exit(0);
+        }
+        kids[i] = c;
+    }
+    while (atomic_load(ready) < n) usleep(1000);
+    if (atomic_load(failed)){
+        int e = atomic_load(failed);
+        for (int i=0;i<n;i++){ kill(kids[i], SIGKILL); waitpid(kids[i], NULL, 0); }
+        munmap(page, bytes); free(kids);
+        errno = e; return false;
+    }
+    if (policy != SCHED_OTHER) sched_setscheduler(0, SCHED_FIFO, &pp);    /* stay above the children */
+    long long base = now_ns() + 10000000;
+    for (int r=0;r<n;r++){
+        int i = ord[r];
+        exec_until(base + pr[i].arrival * tick_ns);
+        sl[i].t[0] = base;
+        atomic_store(&sl[i].gate, 1);
+        syscall(SYS_futex, (uint32_t*)&sl[i].gate, FUTEX_WAKE, 1, NULL, NULL, 0);
+    }
+    if (policy != SCHED_OTHER) sched_setscheduler(0, old_pol, &old_pp);
+    for (int i=0;i<n;i++) waitpid(kids[i], NULL, 0);
+    for (int i=0;i<n;i++){ start[i] = (int)llround((double)sl[i].t[0] / tick_ns); end[i] = (int)llround((double)sl[i].t[1] / tick_ns); }
+    munmap(page, bytes); free(kids);
+    return true;
+}
+
+static void calib_run(const Proc *pr, int n, Csv *csv, const Config *cfg){
+    static const char *NM[3] = {"OTHER", "RR", "FIFO"};
+    static const int POL[3] = {SCHED_OTHER, SCHED_RR, SCHED_FIFO};
+    if (n > CALIB_MAX_PROCS){ fprintf(stderr,"ERROR: --calibrate forks one process per job, at most %d\n", CALIB_MAX_PROCS); exit(1); }
+    cpu_set_t cs, mine, rest;
+    if (!parse_cpu_list(cfg->calib_cpus, &cs)){ fprintf(stderr,"ERROR: bad --calib-cpus list: %s\n", cfg->calib_cpus); exit(1); }
+    if (sched_getaffinity(0, sizeof(mine), &mine) != 0){ fprintf(stderr,"ERROR: sched_getaffinity: %s\n", strerror(errno)); exit(1); }
+    CPU_AND(&cs, &cs, &mine);
+    if (!CPU_COUNT(&cs)){ fprintf(stderr,"ERROR: none of --calib-cpus=%s is available to this process\n", cfg->calib_cpus); exit(1); }
+    char cpus[256]; format_cpu_list(&cs, cpus, sizeof(cpus));
+    CPU_ZERO(&rest);
+    for (int c=0;c<CPU_SETSIZE;c++) if (CPU_ISSET(c, &mine) && !CPU_ISSET(c, &cs)) CPU_SET(c, &rest);
+    bool moved = CPU_COUNT(&rest) > 0 && sched_setaffinity(0, sizeof(rest), &rest) == 0;
+    int *ord = arrival_order(pr, n);
+    int *start = (int*)malloc(n*sizeof(int)), *end = (int*)malloc(n*sizeof(int));
+    if (!start || !end){ fprintf(stderr,"OOM\n"); exit(1); }
+    printf("\nKernel calibration on CPUs %s, tick %d us%s =>\n", cpus, cfg->tick_us,
+           moved ? "" : " (the parent shares those CPUs; arrivals may slip)");
+    for (int p=0;p<3;p++){
+        if (!(cfg->calib_mask & (1<<p))) continue;
+        char alg[32]; snprintf(alg, sizeof(alg), "Kernel-%s", NM[p]);
+        printf("SCHED_%s =>\n", NM[p]); fflush(stdout);
+        if (!calib_policy(pr, n, ord, POL[p], &cs, cfg->tick_us * 1000LL, start, end)){
+            printf("  skipped: %s\n\n", strerror(errno)); continue;
+        }
+        print_avgs(alg, pr, n, start, end);
+        csv_dump_algo(csv, alg, pr, n, start, end);
+    }
+    if (moved) sched_setaffinity(0, sizeof(mine), &mine);
+    free(ord); free(start); free(end);
+}
+
+/* ===================== Paced replay ===================== */
+/* --replay=ALG emits the schedule of one engine in wall-clock time for an
+   external harness. Each segment boundary becomes text lines
+     <time> DISPATCH|PREEMPT|COMPLETE <pid>
+   written to --replay-to (a path such as a named pipe, unix:PATH for a
+   stream socket, or - for stdout) when base + time * tick-us * --time-scale
+   comes round. Lines of one instant go out in a single write. The writer
+   sleeps with clock_nanosleep and spins the last stretch; lateness per
+   instant is reported as jitter. */
+
+static int replay_open(const char *to){
+    if (!strcmp(to, "-")) return STDOUT_FILENO;
+    if (!strncmp(to, "unix:", 5)){
+        struct sockaddr_un sa; memset(&sa, 0, sizeof(sa)); sa.sun_family = AF_UNIX;
+        if (strlen(to + 5) >= sizeof(sa.sun_path)){ fprintf(stderr,"ERROR: socket path too long: %s\n", to + 5); exit(1); }
+        memcpy(sa.sun_path, to + 5, strlen(to + 5));
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || connect(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0){ fprintf(stderr,"ERROR: cannot connect to %s: %s\n", to, strerror(errno)); exit(1); }
+        return fd;
+    }
+    int fd = open(to, O_WRONLY | O_CREAT | O_TRUNC, 0644);   /* blocks until a FIFO has a reader */
+    if (fd < 0){ fprintf(stderr,"ERROR: cannot open %s: %s\n", to, strerror(errno)); exit(1); }
+    return fd;
+}
+
+static void replay_run(const Proc *pr, int n, const Config *cfg){
+    Policy p; policy_set(&p, cfg->replay_alg, cfg->quantum);
+    Config q = quiet_config(cfg);
+    SegVec sv = {0};
+    int *st = (int*)malloc(n*sizeof(int)), *en = (int*)malloc(n*sizeof(int));
+    if (!st || !en){ fprintf(stderr,"OOM\n"); exit(1); }
+    SimOut so; simout_init(&so, st, en, NULL, &sv);
+    sim_policy(&p, pr, n, &q, &so);
+    int *ix = pid_index(pr, n);
+    long long *late = (long long*)malloc((sv.len + 1)*sizeof(long long));
+    if (!late){ fprintf(stderr,"OOM\n"); exit(1); }
+
+    signal(SIGPIPE, SIG_IGN);
+    fflush(stdout);
+    int fd = replay_open(cfg->replay_to);
+    const double unit = cfg->tick_us * 1000.0 * cfg->time_scale;    /* ns per tick */
+    fprintf(stderr, "Replaying %s: %d segments over about %.3f s\n", p.name, sv.len, so.stop * unit / 1e9);
+    char buf[256]; int nl = 0; long long lines = 0;
+    long long base = now_ns() + 1000000;
+    int prev = -1;                                      /* job of the segment just ended */
+    for (int k=0;k<=sv.len;k++){
+        int t = k < sv.len ? sv.a[k].start : sv.a[k-1].end, len = 0;
+        if (prev >= 0){
+            len += snprintf(buf + len, sizeof(buf) - len, "%d %s %d\n", t, en[prev] == t ? "COMPLETE" : "PREEMPT", pr[prev].pid);
+            lines++;
+        }
+        prev = -1;
+        if (k < sv.len && sv.a[k].pid >= 0){
+            prev = pid_lookup(pr, ix, n, sv.a[k].pid);
+            len += snprintf(buf + len, sizeof(buf) - len, "%d DISPATCH %d\n", t, sv.a[k].pid);
+            lines++;
+        }
+        if (!len) continue;
+        long long at = base + (long long)(t * unit);
+        exec_until(at);
+        if (write(fd, buf, len) != len){ fprintf(stderr,"ERROR: replay stopped: %s\n", strerror(errno)); break; }
+        late[nl++] = now_ns() - at;                     /* written, i.e. delivered to the reader */
+    }
+    if (fd != STDOUT_FILENO) close(fd);
+    qsort(late, nl, sizeof(long long), cmp_ll);
+    double s = 0; for (int i=0;i<nl;i++) s += late[i];
+    printf("\nPaced replay of %s to %s (tick %d us x %.3g) =>\n", p.name, cfg->replay_to, cfg->tick_us, cfg->time_scale);
+    if (nl) printf("  %lld events at %d instants; jitter mean %.1f us, p50 %.1f, p99 %.1f, max %.1f\n\n",
+                   lines, nl, s / nl / 1e3, late[nl/2] / 1e3, late[(int)((nl-1) * 0.99)] / 1e3, late[nl-1] / 1e3);
+    seg_free(&sv); free(st); free(en); free(ix); free(late);
+}
+
+/* ===================== Adversarial search ===================== */
+/* --adversary=A,B searches for workloads on which policy A does worst
+   relative to B (opt = SRTF, optimal for mean turnaround) on --adv-metric.
+   The input trace seeds a genetic search. Each generation keeps the best
+   quarter and refills the population with mutated children (jittered
+   arrivals, scaled or nudged bursts) and uniform crossovers. A fixed pool of
+   threads evaluates candidates by calling sim_policy directly; the sort
+   helpers keep their comparison context in thread-local storage for this.
+   The best workloads found are written in input format to
+   <--adv-out>_1.txt... for regression tests. */
+
+enum { ADV_MEAN_TAT=0, ADV_MAX_TAT=1, ADV_MEAN_RESP=2 };
+#define ADV_KEEP 3                     /* best workloads written out */
+
+typedef struct { Proc *pr; double a, b, score; } AdvCand;
+
+typedef struct {
+    AdvCand *pop; int npop, n;
+    Policy A, B; int metric;
+    Config q;
+    atomic_int next;
+    pthread_barrier_t go, done;
+    bool quit;
+} AdvPool;
+
+static double adv_metric(const Proc *pr, int n, const int *start, const int *end, int metric){
+    double s = 0, mx = 0;
+    for (int i=0;i<n;i++){
+        double v = metric == ADV_MEAN_RESP ? start[i] - pr[i].arrival : end[i] - pr[i].arrival;
+        s += v; if (v > mx) mx = v;
+    }
+    return metric == ADV_MAX_TAT ? mx : s / n;
+}
+
+static void *adv_worker(void *arg){
+    AdvPool *ap = (AdvPool*)arg;
+    const int n = ap->n;
+    int *st = (int*)malloc(n*sizeof(int)), *en = (int*)malloc(n*sizeof(int));
+    if (!st || !en){ fprintf(stderr,"OOM\n"); exit(1); }
+    for (;;){
+        pthread_barrier_wait(&ap->go);
+        if (ap->quit) break;
+        for (int c; (c = atomic_fetch_add(&ap->next, 1)) < ap->npop; ){
+            AdvCand *x = &ap->pop[c];
+            SimOut so; simout_init(&so, st, en, NULL, NULL);
+            sim_policy(&ap->A, x->pr, n, &ap->q, &so); x->a = adv_metric(x->pr, n, st, en, ap->metric);
+            sim_policy(&ap->B, x->pr, n, &ap->q, &so); x->b = adv_metric(x->pr, n, st, en, ap->metric);
+            x->score = x->a / (x->b > 0 ? x->b : 1);
+        }
+        pthread_barrier_wait(&ap->done);
+    }
+    free(st); free(en);
+    return NULL;
+}
+
+static int cmp_adv(const void *x, const void *y){
+    double a = ((const AdvCand*)x)->score, b = ((const AdvCand*)y)->score;
+    return (a < b) - (a > b);                          /* best first */
+}
+
+static void adv_mutate(Proc *w, int n, uint64_t *rs, int amax, int bmax){
+    int m = 1 + (int)rng_below(rs, 3);
+    while (m--){
+        Proc *p = &w[rng_below(rs, n)];
+        long long a = p->arrival, b = p->burst;   /* wide, so the clamps see the true value */
+        switch (rng_below(rs, 4)){
+        case 0: a += (long long)rng_below(rs, 2 * (amax / 8 + 1) + 1) - (amax / 8 + 1); break;
+        case 1: b *= 2; break;
+        case 2: b /= 2; break;
+        default: b += (long long)rng_below(rs, 5) - 2; break;
+        }
+        p->arrival = a < 0 ? 0 : a > amax ? amax : (int)a;
+        p->burst = b < 1 ? 1 : b > bmax ? bmax : (int)b;
+    }
+}
+
+static void adversary_run(const Proc *seed, int n, const Config *cfg){
+    static const char *MN[3] = {"mean turnaround", "max turnaround", "mean response"};
+    AdvPool ap; memset(&ap, 0, sizeof(ap));
+    ap.n = n; ap.metric = cfg->adv_metric;
+    policy_set(&ap.A, cfg->adv_alg[0], cfg->adv_q[0]); policy_set(&ap.B, cfg->adv_alg[1], cfg->adv_q[1]);
+    ap.q = quiet_config(cfg); ap.q.ext = NULL; ap.q.reneging = false;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    int nth = ncpu < 1 ? 1 : ncpu > 64 ? 64 : (int)ncpu;
+    ap.npop = cfg->adv_pop;
+    int elite = ap.npop / 4 > 0 ? ap.npop / 4 : 1;
+    ap.pop = (AdvCand*)calloc(ap.npop, sizeof(AdvCand));
+    Proc *spare = (Proc*)malloc((size_t)ap.npop * n * sizeof(Proc));
+    if (!ap.pop || !spare){ fprintf(stderr,"OOM\n"); exit(1); }
+    int amax = 0, bmax = 1;
+    for (int i=0;i<n;i++){ if (seed[i].arrival > amax) amax = seed[i].arrival; if (seed[i].burst > bmax) bmax = seed[i].burst; }
+    /* mutation bounds, computed wide: a makespan of at most A + n*B must
+       stay inside the engines' int clock, but never below the seed's own */
+    long long B = 16LL * bmax, A = 2LL * amax + B, room = INT_MAX / 2;
+    if (B > room / n) B = room / n > bmax ? room / n : bmax;
+    if (A > room) A = room > amax ? room : amax;
+    amax = (int)A; bmax = (int)B;
+    uint64_t rs = cfg->seed;
+    for (int c=0;c<ap.npop;c++){
+        ap.pop[c].pr = (Proc*)malloc(n*sizeof(Proc));
+        if (!ap.pop[c].pr){ fprintf(stderr,"OOM\n"); exit(1); }
+        memcpy(ap.pop[c].pr, seed, n*sizeof(Proc));
+        if (c) adv_mutate(ap.pop[c].pr, n, &rs, amax, bmax);
+    }
+    pthread_barrier_init(&ap.go, NULL, nth + 1); pthread_barrier_init(&ap.done, NULL, nth + 1);
+    pthread_t th[64];
+    for (int i=0;i<nth;i++) if (pthread_create(&th[i], NULL, adv_worker, &ap)){ fprintf(stderr,"ERROR: cannot start search worker\n"); exit(1); }
+
+    printf("\nAdversarial search: %s vs %s on %s, %d jobs, population %d, %d generations, %d threads =>\n",
+           ap.A.name, ap.B.name, MN[ap.metric], n, ap.npop, cfg->adv_gens, nth);
+    double seed_score = 0;
+    for (int g=0; g<=cfg->adv_gens; g++){
+        atomic_store(&ap.next, g ? elite : 0);         /* elites keep their scores */
+        pthread_barrier_wait(&ap.go); pthread_barrier_wait(&ap.done);
+        if (!g) seed_score = ap.pop[0].score;           /* slot 0 holds the input trace unmutated */
+        qsort(ap.pop, ap.npop, sizeof(AdvCand), cmp_adv);
+        if (g % 10 == 0 || g == cfg->adv_gens)
+            printf("  gen %4d  best ratio %.4f  (%s %.2f vs %.2f)\n", g, ap.pop[0].score, MN[ap.metric], ap.pop[0].a, ap.pop[0].b);
+        if (g == cfg->adv_gens) break;
+        /* children overwrite the non-elite slots: mutate one elite, or cross two */
+        for (int c=elite;c<ap.npop;c++){
+            Proc *w = spare + (size_t)c * n;
+            const Proc *p1 = ap.pop[rng_below(&rs, elite)].pr;
+            if (rng_below(&rs, 4) == 0){
+                const Proc *p2 = ap.pop[rng_below(&rs, elite)].pr;
+                for (int i=0;i<n;i++) w[i] = rng_below(&rs, 2) ? p1[i] : p2[i];
+            } else memcpy(w, p1, n*sizeof(Proc));
+            adv_mutate(w, n, &rs, amax, bmax);
+        }
+        for (int c=elite;c<ap.npop;c++) memcpy(ap.pop[c].pr, spare + (size_t)c * n, n*sizeof(Proc));
+    }
+    ap.quit = true;
+    pthread_barrier_wait(&ap.go);
+    for (int i=0;i<nth;i++) pthread_join(th[i], NULL);
+    pthread_barrier_destroy(&ap.go); pthread_barrier_destroy(&ap.done);
+
+    printf("  seed ratio %.4f -> best %.4f\n", seed_score, ap.pop[0].score);
+    for (int b=0; b<ADV_KEEP && b<ap.npop; b++){
+        char path[300]; snprintf(path, sizeof(path), "%s_%d.txt", cfg->adv_out, b + 1);
+        FILE *f = fopen(path, "w");
+        if (!f){ fprintf(stderr,"ERROR: cannot open %s for writing\n", path); exit(1); }
+        fprintf(f, "%d\n", n);
+        for (int i=0;i<n;i++) fprintf(f, "%d %d %d\n", ap.pop[b].pr[i].pid, ap.pop[b].pr[i].arrival, ap.pop[b].pr[i].burst);
+        fclose(f);
+        printf("  saved %s (ratio %.4f)\n", path, ap.pop[b].score);
+    }
+    printf("\n");
+    for (int c=0;c<ap.npop;c++) free(ap.pop[c].pr);
+    free(ap.pop); free(spare);
+}
+
+/* ===================== Schedule diff ===================== */
+/* --diff=A,B merge-walks two coalesced timelines. Each side is either a
+   policy run live on the workload or a --segments file, which is read one
+   segment at a time. Gaps between segments count as idle. The walk visits
+   each segment once and reports the first instant the running process
+   differs, the total time the two CPUs hold different processes, and the
+   processes whose completion (the end of their last segment) moved most.
+   Stored streams cost one map entry per process, whatever the segment count. */
+
+typedef struct {
+    FILE *f; const SegVec *sv; int i;   /* stored stream, or a live timeline */
+    char name[256];
+    Seg cur; bool more;
+    long long nseg; int last_end;
+} SegStream;
+
+static void ss_next(SegStream *s){
+    for (;;){
+        Seg g;
+        if (s->f){
+            int r = fscanf(s->f, "%d %d %d", &g.start, &g.end, &g.pid);
+            if (r == EOF){ s->more = false; return; }
+            if (r != 3){ fprintf(stderr,"ERROR: %s: malformed segment after %lld\n", s->name, s->nseg); exit(1); }
+        } else {
+            if (s->i == s->sv->len){ s->more = false; return; }
+            g = s->sv->a[s->i++];
+        }
+        if (g.end < g.start || g.start < s->last_end){
+            fprintf(stderr,"ERROR: %s: segment [%d,%d) is reversed or overlaps the previous one\n", s->name, g.start, g.end); exit(1);
+        }
+        if (g.end == g.start) continue;
+        s->cur = g; s->last_end = g.end; s->nseg++; s->more = true;
+        return;
+    }
+}
+
+/* pid -> last segment end in each stream (-1 = never ran there) */
+typedef struct { int pid; int end[2]; } DiffJob;
+typedef struct { DiffJob *a; int cap, len; } DiffMap;
+
+static DiffJob *dm_get(DiffMap *m, int pid){
+    if (2 * (m->len + 1) > m->cap){
+        DiffMap g = { (DiffJob*)malloc((m->cap ? 2 * m->cap : 1024) * sizeof(DiffJob)), m->cap ? 2 * m->cap : 1024, 0 };
+        if (!g.a){ fprintf(stderr,"OOM\n"); exit(1); }
+        for (int i=0;i<g.cap;i++) g.a[i].pid = INT_MIN;
+        for (int i=0;i<m->cap;i++) if (m->a[i].pid != INT_MIN){
+            DiffJob *d = dm_get(&g, m->a[i].pid); d->end[0] = m->a[i].end[0]; d->end[1] = m->a[i].end[1];
+        }
+        free(m->a); *m = g;
+    }
+    unsigned h = ((unsigned)pid * 2654435761u) & (unsigned)(m->cap - 1);
+    while (m->a[h].pid != INT_MIN && m->a[h].pid != pid) h = (h + 1) & (unsigned)(m->cap - 1);
+    if (m->a[h].pid == INT_MIN){ m->a[h].pid = pid; m->a[h].end[0] = m->a[h].end[1] = -1; m->len++; }
+    return &m->a[h];
+}
+
+static int cmp_shift(const void *x, const void *y){
+    const DiffJob *a = (const DiffJob*)x, *b = (const DiffJob*)y;
+    long long da = llabs((long long)a->end[1] - a->end[0]), db = llabs((long long)b->end[1] - b->end[0]);
+    if (da != db) return (da < db) - (da > db);                /* largest first */
+    return (a->pid > b->pid) - (a->pid < b->pid);
+}
+
+static void diff_walk(SegStream *s, const Config *cfg){
+    DiffMap m = {0};
+    ss_next(&s[0]); ss_next(&s[1]);
+    long long t = s[0].more ? s[0].cur.start : 0, differ = 0, first = -1;
+    if (s[1].more && (!s[0].more || s[1].cur.start < t)) t = s[1].cur.start;
+    long long t0 = t;
+    int first_occ[2] = {-1, -1};
+    while (s[0].more || s[1].more){
+        long long nb = LLONG_MAX; int occ[2];
+        for (int k=0;k<2;k++){
+            occ[k] = -1;
+            if (!s[k].more) continue;
+            if (s[k].cur.start <= t){ occ[k] = s[k].cur.pid; if (s[k].cur.end < nb) nb = s[k].cur.end; }
+            else if (s[k].cur.start < nb) nb = s[k].cur.start;
+        }
+        if (occ[0] != occ[1]){
+            if (first < 0){ first = t; first_occ[0] = occ[0]; first_occ[1] = occ[1]; }
+            differ += nb - t;
+        }
+        t = nb;
+        for (int k=0;k<2;k++) if (s[k].more && s[k].cur.end <= t){
+            if (s[k].cur.pid >= 0) dm_get(&m, s[k].cur.pid)->end[k] = s[k].cur.end;
+            ss_next(&s[k]);
+        }
+    }
+
+    printf("\nSchedule diff: %s (%lld segments) vs %s (%lld segments) =>\n", s[0].name, s[0].nseg, s[1].name, s[1].nseg);
+    if (first < 0) printf("  timelines are identical over [%lld,%lld)\n", t0, t);
+    else {
+        char w[2][24];
+        for (int k=0;k<2;k++){
+            if (first_occ[k] < 0) snprintf(w[k], sizeof(w[k]), "idle");
+            else snprintf(w[k], sizeof(w[k]), "P%d", first_occ[k]);
+        }
+        printf("  first divergence at t=%lld: A %s, B %s\n", first, w[0], w[1]);
+        printf("  differing occupancy: %lld of %lld time units (%.2f%%)\n", differ, t - t0, t > t0 ? 100.0 * differ / (t - t0) : 0.0);
+    }
+    /* compact the map to the processes that ran in both and moved */
+    int moved = 0, only[2] = {0, 0}; long long abs_sum = 0;
+    for (int i=0;i<m.cap;i++){
+        DiffJob d = m.a[i];
+        if (d.pid == INT_MIN) continue;
+        if (d.end[0] < 0 || d.end[1] < 0){ only[d.end[0] < 0]++; continue; }
+        if (d.end[0] == d.end[1]) continue;
+        abs_sum += llabs((long long)d.end[1] - d.end[0]);
+        m.a[moved++] = d;
+    }
+    printf("  completions: %d of %d processes moved, mean |shift| %.2f; only in A: %d, only in B: %d\n",
+           moved, m.len, moved ? (double)abs_sum / moved : 0.0, only[0], only[1]);
+    int top = moved < cfg->diff_top ? moved : cfg->diff_top;
+    if (top){
+        qsort(m.a, moved, sizeof(DiffJob), cmp_shift);
+        printf("  largest shifts:\n");
+        for (int i=0;i<top;i++)
+            printf("    P%-6d A %-8d B %-8d (%+lld)\n", m.a[i].pid, m.a[i].end[0], m.a[i].end[1], (long long)m.a[i].end[1] - m.a[i].end[0]);
+    }
+    printf("\n");
+    free(m.a);
+}
+
+/* pr is NULL when both sides are stored streams */
+static void diff_run(const Proc *pr, int n, const Config *cfg){
+    SegStream s[2]; SegVec sv[2] = {{0}}; int *start = NULL, *end = NULL;
+    Config q = quiet_config(cfg); q.ext = NULL; q.reneging = false;
+    if (pr){
+        start = (int*)malloc(n*sizeof(int)); end = (int*)malloc(n*sizeof(int));
+        if (!start || !end){ fprintf(stderr,"OOM\n"); exit(1); }
+    }
+    for (int k=0;k<2;k++){
+        memset(&s[k], 0, sizeof(SegStream));
+        if (cfg->diff_alg[k] >= 0){
+            Policy p; policy_set(&p, cfg->diff_alg[k], cfg->diff_q[k]);
+            SimOut so; simout_init(&so, start, end, NULL, &sv[k]);
+            sim_policy(&p, pr, n, &q, &so);
+            s[k].sv = &sv[k];
+            snprintf(s[k].name, sizeof(s[k].name), "%s", p.name);
+        } else {
+            s[k].f = fopen(cfg->diff_side[k], "r");
+            if (!s[k].f){ fprintf(stderr,"ERROR: cannot open %s\n", cfg->diff_side[k]); exit(1); }
+            snprintf(s[k].name, sizeof(s[k].name), "%s", cfg->diff_side[k]);
+        }
+    }
+    diff_walk(s, cfg);
+    for (int k=0;k<2;k++){ if (s[k].f) fclose(s[k].f); seg_free(&sv[k]); }
+    free(start); free(end);
+}
+
+/* ===================== Main ===================== */
+
+static volatile sig_atomic_t g_term = 0;
+static void on_term(int sig){ (void)sig; g_term = 1; }
+
+int main(int argc, char **argv){
+    if (argc >= 2 && !strcmp(argv[1], "decode-audit")) return audit_decode(argc >= 3 ? argv[2] : NULL);
+    Config cfg; config_default(&cfg); parse_args(&cfg, argc, argv);
+    if (cfg.periodic_path[0]){ periodic_run(&cfg); return 0; }
+    if (cfg.diff_side[0][0] && cfg.diff_alg[0] < 0 && cfg.diff_alg[1] < 0){ diff_run(NULL, 0, &cfg); return 0; }
+
+    Audit audit;
+    if (cfg.audit_path[0]){ audit_open(&audit, cfg.audit_path); cfg.audit = &audit; }
+
+    /* In daemon mode the exporter threads start with SIGINT/SIGTERM blocked,
+       so the signals always reach main, which waits for them in sigsuspend. */
+    sigset_t term, unblocked;
+    sigemptyset(&term); sigaddset(&term, SIGINT); sigaddset(&term, SIGTERM);
+    if (cfg.daemon){
+        struct sigaction sa; memset(&sa, 0, sizeof(sa)); sa.sa_handler = on_term;
+        sigaction(SIGINT, &sa, NULL); sigaction(SIGTERM, &sa, NULL);
+        pthread_sigmask(SIG_BLOCK, &term, &unblocked);
+    }
+    Metrics met;
+    if (cfg.metrics_path[0] || cfg.metrics_port){ metrics_start(&met, &cfg); cfg.metrics = &met; }
+    if (cfg.daemon) pthread_sigmask(SIG_SETMASK, &unblocked, NULL);
+
+    Csv csv; csv_open(&csv, &cfg);
+    GitTab git;
+    if (cfg.gittins_path[0]) git_load(&git, cfg.gittins_path);
+
+    /* one workload normally; in daemon mode keep going until EOF */
+    int rc = 0;
+    for (int round=0; !g_term; round++){
+        printf("Number of Processes: ");
+        int n;
+        if (round == 0) n = read_int("number of processes");
+        else if (scanf("%d",&n) != 1){ printf("\n"); break; }
+        if (n <= 0){ fprintf(stderr,"ERROR: n must be positive\n"); rc = 1; break; }
+        if (cfg.pipeline || cfg.lockstep){
+            printf("Enter details for each process on its own line: PID Arrival Burst\n");
+            stream_run(n, &csv, &cfg);
+            break;
+        }
+
+        Proc *pr = (Proc*)malloc(n*sizeof(Proc));
+        if (!pr){ fprintf(stderr,"OOM\n"); return 1; }
+
+        JobExt ext; memset(&ext, 0, sizeof(ext));
+        for (int k=0;k<cfg.ncols;k++) if (cfg.cols[k] > COL_BURST){
+            ext.v[cfg.cols[k]] = (int*)malloc(n*sizeof(int));
+            if (!ext.v[cfg.cols[k]]){ fprintf(stderr,"OOM\n"); return 1; }
+        }
+        cfg.ext = &ext;
+        cfg.reneging = cfg.patience >= 0 || ext.v[COL_PATIENCE];
+
+        if (cfg.ncols == 3) printf("Enter details for each process on its own line: PID Arrival Burst\n");
+        else {
+            printf("Enter details for each process on its own line:");
+            for (int k=0;k<cfg.ncols;k++) printf(" %s", COL_NAMES[cfg.cols[k]]);
+            printf("\n");
+        }
+        for (int i=0;i<n && !rc;i++){
+            int v[NCOLS];
+            for (int k=0;k<cfg.ncols;k++) v[cfg.cols[k]] = read_int(COL_NAMES[cfg.cols[k]]);
+            if (v[COL_ARRIVAL] < 0 || v[COL_BURST] <= 0){ fprintf(stderr,"ERROR: Arrival >= 0, Burst > 0\n"); rc = 1; }
+            pr[i].pid=v[COL_PID]; pr[i].arrival=v[COL_ARRIVAL]; pr[i].burst=v[COL_BURST];
+            for (int c=COL_BURST+1;c<NCOLS;c++) if (ext.v[c]) ext.v[c][i] = v[c];
+        }
+        if (rc){
+            free(pr);
+            for (int c=0;c<NCOLS;c++) free(ext.v[c]);
+            cfg.ext = NULL;
+            break;
+        }
+
+        if (csv.norm) norm_workload(csv.norm, csv.norm->row_base, pr, n);
+        if (cfg.profile)  profile_workload(pr, n, &cfg);
+        if (cfg.recommend) recommend(pr, n, &cfg);
+        else if (cfg.sample) sample_run(pr, n, &cfg);
+        else if (cfg.cluster) cluster_run(pr, n, &csv, &cfg);
+        else if (cfg.nscale) autoscale_run(pr, n, &cfg);
+        else if (cfg.machines) pack_run(pr, n, &cfg);
+        else if (cfg.exec_alg >= 0) exec_run(pr, n, &csv, &cfg);
+        else if (cfg.calib_mask) calib_run(pr, n, &csv, &cfg);
+        else if (cfg.replay_alg >= 0) replay_run(pr, n, &cfg);
+        else if (cfg.adv_alg[0] >= 0) adversary_run(pr, n, &cfg);
+        else if (cfg.diff_side[0][0]) diff_run(pr, n, &cfg);
+        else if (cfg.gang) gang_run(pr, n, &cfg);
+        else if (cfg.mold) mold_run(pr, n, &cfg);
+        else if (cfg.smp && cfg.smt) smt_run(pr, n, &cfg);
+        else if (cfg.smp) smp_run(pr, n, &cfg);
+        else if (cfg.locks_path[0]){
+            /* non-preemptive engines never find a lock held on one CPU */
+            LockSet ls; locks_load(&ls, cfg.locks_path, pr, n);
+            if (cfg.run_fcfs) run_fcfs(pr, n, &csv, &cfg);
+            if (cfg.run_sjf)  run_sjf (pr, n, &csv, &cfg);
+            if (cfg.run_srtf) run_locks(pr, n, ALG_SRTF, cfg.quantum, &ls, &csv, &cfg);
+            if (cfg.run_rr)   run_locks(pr, n, ALG_RR, cfg.quantum, &ls, &csv, &cfg);
+            locks_free(&ls);
+        }
+        else {
+            if (cfg.run_fcfs) run_fcfs(pr, n, &csv, &cfg);
+            if (cfg.run_sjf)  run_sjf (pr, n, &csv, &cfg);
+            if (cfg.run_srtf) run_srtf(pr, n, &csv, &cfg);
+            if (cfg.run_rr)   run_rr  (pr, n, cfg.quantum, &csv, &cfg);
+            if (cfg.gittins_path[0]) run_gittins(pr, n, &git, &csv, &cfg);
+        }
+
+        free(pr);
+        for (int c=0;c<NCOLS;c++) free(ext.v[c]);
+        cfg.ext = NULL;
+        if (csv.norm) csv.norm->row_base += n;
+        if (!cfg.daemon) break;
+        fflush(stdout);
+    }
+
+    if (cfg.gittins_path[0]) git_free(&git);
+    if (csv.open){ csv_close(&csv); printf("CSV written: %s\n", cfg.csv_path); }
+    if (csv.norm){ long long bytes = norm_close(csv.norm); printf("Normalised tables written: %s_*.csv (%lld bytes)\n", cfg.norm_prefix, bytes); free(csv.norm); }
+    if (cfg.audit){ audit_close(&audit); printf("Audit log written: %s (%lld records)\n", cfg.audit_path, audit.records); }
+    if (cfg.metrics){
+        if (cfg.daemon && cfg.metrics_port){
+            printf("Serving metrics on 127.0.0.1:%d until SIGTERM\n", cfg.metrics_port); fflush(stdout);
+            pthread_sigmask(SIG_BLOCK, &term, NULL);
+            while (!g_term) sigsuspend(&unblocked);
+        }
+        metrics_stop(&met);
+        if (cfg.metrics_path[0]) printf("Metrics written: %s\n", cfg.metrics_path);
+    }
+    return rc;
+}